@@ -0,0 +1,90 @@
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Encodes frames on a dedicated thread through a ring of preallocated buffers.
+ *
+ * write() copies the frame into the next free slot of a fixed-size ring of `cv::Mat`
+ * buffers, allocated once up front, and returns immediately. A background thread hands
+ * the slots to the underlying `cv::VideoWriter` in order. When the encoder falls behind
+ * and the ring is full, the overflow policy decides whether write() waits for a free slot
+ * or drops the frame.
+ *
+ * write() must be called from a single producer thread.
+ */
+class AsyncVideoWriter
+{
+public:
+    enum class OverflowPolicy
+    {
+        Block, // Wait for the encoder to free a slot.
+        Drop   // Discard the frame being written.
+    };
+
+    /**
+     * @brief Preallocates the ring and starts the encoding thread.
+     *
+     * @param writer Opened video writer; must outlive this object and not be used elsewhere meanwhile.
+     * @param frame_size Size of the frames that will be written.
+     * @param frame_type OpenCV type of the frames that will be written (e.g. CV_8UC3).
+     * @param capacity Number of frames in the ring.
+     * @param policy What to do when the ring is full.
+     */
+    AsyncVideoWriter(cv::VideoWriter &writer, const cv::Size &frame_size, int frame_type, size_t capacity = 8,
+                     OverflowPolicy policy = OverflowPolicy::Block);
+
+    /**
+     * @brief Flushes the frames still in the ring and joins the encoding thread.
+     */
+    ~AsyncVideoWriter();
+
+    AsyncVideoWriter(const AsyncVideoWriter &) = delete;
+    AsyncVideoWriter &operator=(const AsyncVideoWriter &) = delete;
+
+    /**
+     * @brief Queues a copy of a frame for encoding.
+     *
+     * @param frame Frame to write; the caller keeps ownership of it.
+     * @return false if the frame was dropped or the writer is closed.
+     */
+    bool write(const cv::Mat &frame);
+
+    /**
+     * @brief Waits until every queued frame has been encoded and stops the encoding thread.
+     */
+    void close();
+
+    /**
+     * @brief Number of frames dropped because the ring was full.
+     */
+    size_t dropped() const;
+
+    /**
+     * @brief Time spent inside cv::VideoWriter::write, in milliseconds.
+     */
+    double encode_ms() const;
+
+private:
+    void run();
+
+    cv::VideoWriter &writer_;
+    OverflowPolicy policy_;
+    std::vector<cv::Mat> slots_;
+    size_t head_ = 0;  // Next slot to encode.
+    size_t count_ = 0; // Slots waiting to be encoded, including the one being encoded.
+    size_t dropped_ = 0;
+    double encode_ms_ = 0.0;
+    bool closed_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::thread worker_;
+};
+
+#endif // ASYNC_WRITER_HPP
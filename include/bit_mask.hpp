@@ -0,0 +1,87 @@
+#ifndef BIT_MASK_HPP
+#define BIT_MASK_HPP
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Binary mask stored with one bit per pixel.
+ *
+ * Each row is packed into 64-bit words, pixel x of a row being bit x % 64 of word x / 64,
+ * and the bits past the last column of a row are always 0. Morphology and hole filling work
+ * on whole words, i.e. on 64 pixels per operation, and a 1280x720 mask takes 115 KB instead
+ * of 900 KB, so that the intermediate masks of preprocessing_image stay in the L2 cache.
+ *
+ * Every operation gives the same result as its OpenCV counterpart on a 0/255 `cv::Mat`
+ * with the default borders: pixels outside the mask count as 0 for dilate() and as 1 for
+ * erode().
+ */
+class BitMask
+{
+public:
+    BitMask() = default;
+
+    /**
+     * @brief Creates a mask of the given size with every pixel cleared.
+     */
+    explicit BitMask(const cv::Size &size);
+
+    /**
+     * @brief Packs a CV_8U image, setting the pixels that are nonzero.
+     */
+    static BitMask from_mat(const cv::Mat &mask);
+
+    /**
+     * @brief Unpacks the mask into a CV_8U image holding 0 or 255.
+     */
+    void to_mat(cv::Mat &mask) const;
+
+    cv::Size size() const;
+
+    /**
+     * @brief Number of set pixels.
+     */
+    size_t count() const;
+
+    /**
+     * @brief Number of set pixels inside `area`.
+     */
+    size_t count(const cv::Rect &area) const;
+
+    /**
+     * @brief Dilation with a `kernel_size` rectangle centred on each pixel (see cv::dilate).
+     */
+    BitMask dilate(const cv::Size &kernel_size) const;
+
+    /**
+     * @brief Erosion with a `kernel_size` rectangle centred on each pixel (see cv::erode).
+     */
+    BitMask erode(const cv::Size &kernel_size) const;
+
+    /**
+     * @brief Sets every cleared pixel that is not 4-connected to the border by cleared pixels.
+     *
+     * Same result as fill_holes on the unpacked mask. The cleared pixels reachable from the
+     * border are propagated along each row with a Kogge-Stone fill over the words of the row,
+     * and between rows with one AND per word, sweeping down and up until nothing changes.
+     */
+    void fill_holes();
+
+private:
+    uint64_t *row(int y);
+    const uint64_t *row(int y) const;
+
+    // Clears the bits past the last column of every row.
+    void clear_padding();
+
+    // Complements every pixel.
+    void invert();
+
+    int rows_ = 0;
+    int cols_ = 0;
+    int words_ = 0; // Words per row.
+    std::vector<uint64_t> bits_;
+};
+
+#endif // BIT_MASK_HPP
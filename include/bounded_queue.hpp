@@ -0,0 +1,84 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief Fixed-capacity blocking FIFO used to connect two pipeline stages.
+ *
+ * Producers block in push() while the queue is full and consumers block in pop()
+ * while it is empty, so a slow stage applies back-pressure to the stages before it
+ * instead of letting frames pile up in memory.
+ *
+ * Once close() has been called, push() fails immediately and pop() keeps returning
+ * the remaining items until the queue is empty.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    /**
+     * @brief Appends an item, waiting while the queue is full.
+     *
+     * @param item Item to enqueue (moved).
+     * @return false if the queue was closed before the item could be added.
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]
+                       { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item, waiting while the queue is empty.
+     *
+     * @param item Output slot for the dequeued item.
+     * @return false once the queue is closed and fully drained.
+     */
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]
+                        { return closed_ || !items_.empty(); });
+        if (items_.empty())
+            return false;
+
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Marks the end of the stream and wakes every waiting producer and consumer.
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    bool closed_ = false;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+#endif // BOUNDED_QUEUE_HPP
@@ -0,0 +1,63 @@
+#ifndef CONTOUR_GEOMETRY_HPP
+#define CONTOUR_GEOMETRY_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Contour stored as a structure of arrays: all the x coordinates, then all the y.
+ *
+ * `cv::Point` interleaves x and y, so a per-point formula has to shuffle the two coordinates
+ * apart before it can process several points at once. With separate arrays the kernels below
+ * load one SIMD register of x and one of y and evaluate the formula on every lane.
+ */
+struct ContourCoords
+{
+    std::vector<int> x;
+    std::vector<int> y;
+
+    int size() const { return static_cast<int>(x.size()); }
+};
+
+/**
+ * @brief Splits a contour into its x and y arrays.
+ *
+ * @param contour Contour points, in order.
+ * @param coords Output arrays, reused between calls to avoid reallocations.
+ */
+void split_contour(const std::vector<cv::Point> &contour, ContourCoords &coords);
+
+/**
+ * @brief Squared Euclidean distance of every contour point to `target`.
+ *
+ * The distances are exact integers, so comparing them orders the points exactly as comparing
+ * `cv::norm` would, without any square root. Coordinates must stay below 32768 pixels.
+ *
+ * @param coords Contour points.
+ * @param target Reference point.
+ * @param distances Output, one value per point.
+ */
+void squared_distances(const ContourCoords &coords, const cv::Point &target, std::vector<int> &distances);
+
+/**
+ * @brief Signed perpendicular distance of every contour point to the line through `p1` and `p2`.
+ *
+ * The value for a point p is the cross product (p - p1) x (p2 - p1) divided by `line_length`:
+ * its absolute value is the one returned by point_line_distance(), its sign tells on which side
+ * of the line the point lies.
+ *
+ * @param coords Contour points.
+ * @param p1 First point of the line.
+ * @param p2 Second point of the line.
+ * @param line_length Norm of p2 - p1.
+ * @param distances Output, one value per point.
+ */
+void signed_line_distances(const ContourCoords &coords, const cv::Point &p1, const cv::Point &p2, double line_length,
+                           std::vector<double> &distances);
+
+/**
+ * @brief Index of the first smallest value, or -1 if `values` is empty.
+ */
+int argmin(const std::vector<int> &values);
+
+#endif // CONTOUR_GEOMETRY_HPP
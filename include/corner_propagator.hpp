@@ -0,0 +1,66 @@
+#ifndef CORNER_PROPAGATOR_HPP
+#define CORNER_PROPAGATOR_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Moves the card quads of the last keyframe along with the cards on the frames in between.
+ *
+ * The four corners of every quad are tracked from frame to frame with pyramidal Lucas-Kanade
+ * (`cv::calcOpticalFlowPyrLK`) on a grayscale copy of the ROI reduced `downscale` times on each
+ * side (see small_gray). A corner is trusted when LK converges both forwards and backwards and
+ * the backward track ends within `max_error` small pixels of where it started. A quad with one
+ * lost corner moves it by the mean displacement of the other three; a quad with more is lost.
+ *
+ * The confidence of a frame is the fraction of trusted corners. When it falls below
+ * `min_confidence`, or a quad is lost, propagate() fails and the caller is expected to run
+ * the detection on that frame, then reset() the propagator with its result.
+ */
+class CornerPropagator
+{
+public:
+    /**
+     * @param downscale Reduction factor applied to each side of the ROI.
+     * @param window Size of the LK search window at each pyramid level, in small pixels.
+     * @param levels Number of pyramid levels above the base image.
+     * @param max_error Largest forward-backward error of a trusted corner, in small pixels.
+     * @param min_confidence Smallest fraction of trusted corners for a frame to be accepted.
+     */
+    CornerPropagator(int downscale = 2, const cv::Size &window = cv::Size(15, 15), int levels = 3, double max_error = 1.0,
+                     double min_confidence = 0.75);
+
+    /**
+     * @brief Starts tracking from a keyframe.
+     *
+     * @param roi BGR region of interest of the keyframe.
+     * @param quads Detected quads, in ROI coordinates.
+     */
+    void reset(const cv::Mat &roi, const std::vector<std::vector<cv::Point>> &quads);
+
+    /**
+     * @brief Tracks the quads into the next frame.
+     *
+     * @param roi BGR region of interest of the next frame, of the same size as the keyframe one.
+     * @param quads Output quads, in ROI coordinates and in the order given to reset().
+     * @return false if tracking is not reliable enough on this frame.
+     */
+    bool propagate(const cv::Mat &roi, std::vector<std::vector<cv::Point>> &quads);
+
+    /**
+     * @brief Fraction of the corners trusted by the last call to propagate().
+     */
+    double confidence() const;
+
+private:
+    int downscale_;
+    cv::Size window_;
+    int levels_;
+    double max_error_;
+    double min_confidence_;
+    double confidence_ = 1.0;
+    cv::Mat previous_;                 // Small grayscale ROI of the last frame.
+    std::vector<cv::Point2f> corners_; // Corners of the quads, 4 per quad, in small pixels.
+};
+
+#endif // CORNER_PROPAGATOR_HPP
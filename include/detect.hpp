@@ -30,6 +30,25 @@ torch::jit::script::Module load_card_model(const std::string &model_path);
  */
 std::string recognize_cards(const cv::Mat &value);
 
+/**
+ * @brief Classifies all rank patches of a frame with a single forward pass.
+ *
+ * Every non-empty patch is resized and normalized as in recognize_cards, and the
+ * patches are stacked into one Nx1x128x128 tensor, so the TorchScript dispatch
+ * overhead is paid once per frame instead of once per card.
+ *
+ * @param rank_patches Grayscale rank patches (assumed 1-channel).
+ * @return One label per input patch, in the same order ("Invalid" for empty patches).
+ */
+std::vector<std::string> recognize_cards_batch(const std::vector<cv::Mat> &rank_patches);
+
+/**
+ * @brief Size of the top-left card window searched for the rank symbol.
+ *
+ * @return Window size used by extract_rank_patch_center_based, in warped card pixels.
+ */
+cv::Size rank_window_size();
+
 /**
  * @brief Extracts the rank symbol region using a center-based contour filtering method.
  *
@@ -0,0 +1,83 @@
+#ifndef INFERENCE_SERVER_HPP
+#define INFERENCE_SERVER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Micro-batching scheduler around the card classifier.
+ *
+ * Rank patches can be submitted from any thread, e.g. by several in-flight frames or
+ * several video streams. A dedicated worker thread groups pending patches and classifies
+ * them with recognize_cards_batch. A batch is fired as soon as either:
+ * - `max_batch_size` patches are pending, or
+ * - the oldest pending patch has waited `max_wait`.
+ *
+ * Each caller receives its label through a future, so the latency added to a single patch
+ * is bounded by `max_wait` plus the time of one forward pass.
+ */
+class InferenceServer
+{
+public:
+    /**
+     * @brief Starts the worker thread.
+     *
+     * @param max_batch_size Maximum number of patches classified in one forward pass.
+     * @param max_wait Maximum time the oldest pending patch waits for the batch to fill up.
+     */
+    InferenceServer(size_t max_batch_size, std::chrono::microseconds max_wait);
+
+    /**
+     * @brief Classifies the patches still pending and joins the worker thread.
+     */
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer &) = delete;
+    InferenceServer &operator=(const InferenceServer &) = delete;
+
+    /**
+     * @brief Queues a rank patch for classification.
+     *
+     * @param rank_patch Grayscale rank patch, as accepted by recognize_cards.
+     * @return Future holding the predicted rank label.
+     */
+    std::future<std::string> submit(const cv::Mat &rank_patch);
+
+    /**
+     * @brief Number of forward passes run so far.
+     */
+    size_t batches() const;
+
+    /**
+     * @brief Number of patches classified so far.
+     */
+    size_t patches() const;
+
+private:
+    struct Request
+    {
+        cv::Mat patch;
+        std::promise<std::string> label;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void run();
+
+    size_t max_batch_size_;
+    std::chrono::microseconds max_wait_;
+    size_t batches_ = 0;
+    size_t patches_ = 0;
+    bool stopping_ = false;
+    std::deque<Request> pending_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread worker_;
+};
+
+#endif // INFERENCE_SERVER_HPP
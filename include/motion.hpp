@@ -0,0 +1,70 @@
+#ifndef MOTION_HPP
+#define MOTION_HPP
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Reduces a BGR ROI to a small grayscale image.
+ *
+ * The ROI is shrunk `downscale` times on each side with area interpolation before the color
+ * conversion, so that only the small image is converted.
+ *
+ * @param roi BGR region of interest.
+ * @param downscale Reduction factor applied to each side of the ROI.
+ * @param gray Output grayscale image (CV_8U), at least 1x1.
+ */
+void small_gray(const cv::Mat &roi, int downscale, cv::Mat &gray);
+
+/**
+ * @brief Cheap change detector used to decide whether a frame needs card detection.
+ *
+ * The ROI is reduced to a small grayscale image (`downscale` times smaller on each side,
+ * using area interpolation) and compared with the one stored at the last keyframe. The
+ * absolute difference is averaged over blocks of `block_size` x `block_size` small pixels,
+ * and every block whose mean difference exceeds `block_threshold` counts as changed.
+ *
+ * With the default values a 1024x432 ROI is summarized by a 256x108 image and 32x14 blocks,
+ * so the comparison costs a small fraction of preprocessing_image.
+ */
+class MotionDetector
+{
+public:
+    /**
+     * @param downscale Reduction factor applied to each side of the ROI.
+     * @param block_size Side of a comparison block, in downscaled pixels.
+     * @param block_threshold Mean absolute gray-level difference above which a block has changed.
+     */
+    MotionDetector(int downscale = 4, int block_size = 8, double block_threshold = 12.0);
+
+    /**
+     * @brief Compares the ROI with the last keyframe.
+     *
+     * Before the first keyframe, or if the ROI size changes, the whole ROI counts as changed.
+     *
+     * @param roi BGR region of interest of the current frame.
+     * @return true if at least one block has changed.
+     */
+    bool changed(const cv::Mat &roi);
+
+    /**
+     * @brief Bounding box of the changed blocks found by the last call to changed().
+     *
+     * @return Rectangle in full-resolution ROI coordinates, empty if nothing changed.
+     */
+    cv::Rect changed_region() const;
+
+    /**
+     * @brief Makes the frame last passed to changed() the new reference keyframe.
+     */
+    void set_keyframe();
+
+private:
+    int downscale_;
+    int block_size_;
+    double block_threshold_;
+    cv::Mat current_;
+    cv::Mat reference_;
+    cv::Rect changed_region_;
+};
+
+#endif // MOTION_HPP
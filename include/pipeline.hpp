@@ -0,0 +1,147 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "async_writer.hpp"
+#include "process.hpp"
+
+/**
+ * @brief Per-frame predictions (card quadrilateral and rank label) keyed by frame file name.
+ */
+using Predictions = std::map<std::string, std::vector<std::pair<std::vector<cv::Point>, std::string>>>;
+
+/**
+ * @brief Unit of work passed between pipeline stages.
+ *
+ * Each stage fills in the fields it is responsible for and hands the packet to the next
+ * stage through a bounded queue. `index` is the position of the frame in the input video
+ * and is used by the writer to emit frames in their original order.
+ */
+struct FramePacket
+{
+    int index = 0;
+    cv::Mat frame;                               // Decoded BGR frame, annotated in place by the render stage.
+                                                 // Empty for frames only grabbed in offline stride mode.
+    cv::Rect roi_rect;                           // Table region searched for cards.
+    bool scheduled = false;                      // Chosen as keyframe by the stride controller.
+    bool keyframe = false;                       // Whether detection runs on this frame.
+    double detect_ms = 0.0;                      // Time spent in the detect stage.
+    std::vector<std::vector<cv::Point>> rects;   // Card quadrilaterals in full-frame coordinates.
+    std::vector<std::shared_future<std::string>> pending_texts; // Labels of rects, resolved by the classify stage.
+    std::vector<std::string> texts;              // Rank label of each rect.
+};
+
+/**
+ * @brief Tunable parameters of the frame pipeline.
+ */
+struct PipelineConfig
+{
+    int detection_stride = 2;     // Detection stride, or the initial one when adaptive_stride is set.
+    bool adaptive_stride = true;  // Adapt the stride to hold target_latency_ms (see StrideController).
+    int max_stride = 8;           // Largest stride the adaptive controller may choose.
+    double target_latency_ms = 33.0; // Detection time allowed per frame (33 ms for 30 FPS).
+    size_t queue_capacity = 4;    // Maximum number of packets waiting between two stages.
+    bool show_window = true;      // Display annotated frames with HighGUI.
+    bool render_overlay = true;   // Draw the Hi-Lo overlay; not needed without window or output video.
+    const std::atomic<bool> *interrupted = nullptr; // Set asynchronously (e.g. by a signal handler) to stop the run.
+    bool decode_keyframes_only = false; // Only grab() non-keyframes; their frame stays empty (offline analysis).
+    size_t writer_capacity = 8;   // Frames buffered ahead of the video encoder.
+    AsyncVideoWriter::OverflowPolicy writer_policy = AsyncVideoWriter::OverflowPolicy::Block; // When the encoder falls behind.
+    size_t max_batch_size = 16;   // Maximum number of rank patches per CNN forward pass.
+    int max_batch_wait_us = 2000; // Maximum time a rank patch waits for its batch to fill up.
+    bool track_cards = true;      // Only classify cards that are new or have moved (see CardTracker).
+    bool cache_warps = true;      // Reuse the remap tables of cards that have not moved (see WarpCache); ignored with track_cards.
+    bool rank_corners_only = false; // Warp and preprocess only the rank corner of each card (see get_rank_corners); no warp cache.
+    bool bit_packed_masks = false; // Run the card mask morphology on one bit per pixel (see BitMask).
+    int preprocess_bands = 1;     // Horizontal bands preprocessed in parallel (see preprocessing_image).
+    bool run_length_masks = false; // Keep the card mask as runs from the white threshold to the contours (see RunMask).
+    int detection_downscale = 1;  // Build the card mask and find contours at 1/2 or 1/4 resolution (see upscale_quads).
+    double contour_spacing = 0.0; // Resample the card contours every N pixels of arc length, 0 to keep them whole (see resample_contour).
+    bool motion_gating = true;    // Only detect on keyframes, and in regions, where the ROI changed.
+    bool propagate_corners = true; // Track the quads with optical flow between keyframes (see CornerPropagator).
+    double min_flow_confidence = 0.75; // Fraction of tracked corners below which a frame is detected instead.
+    double motion_threshold = 12.0; // Mean gray-level difference above which a block has changed.
+};
+
+/**
+ * @brief Busy time accumulated by each stage, used to find the bottleneck.
+ */
+struct PipelineStats
+{
+    int frames = 0;
+    int keyframes = 0;
+    int motionless_keyframes = 0;
+    double decode_ms = 0.0;
+    double detect_ms = 0.0;
+    double classify_ms = 0.0;
+    double render_ms = 0.0;
+    double encode_ms = 0.0;
+    size_t dropped_frames = 0;
+    double wall_ms = 0.0;
+    size_t inference_batches = 0;
+    size_t inference_patches = 0;
+    size_t reused_labels = 0;
+    size_t cached_warps = 0;
+    int propagated_frames = 0;       // Non-keyframes whose quads were moved by optical flow.
+    int forced_keyframes = 0;        // Non-keyframes detected because tracking was lost.
+    int reseeded_frames = 0;         // Frames where tracking was lost without motion and restarted from the keyframe quads.
+    int stride = 0;                  // Stride in use at the end of the run.
+    double keyframe_latency_ms = 0.0; // Smoothed detect + classify cost of a keyframe.
+    double intermediate_latency_ms = 0.0; // Smoothed cost of a frame between keyframes, forced detections included.
+    double frame_latency_ms = 0.0;    // Keyframe and intermediate costs amortized over the stride.
+};
+
+/**
+ * @brief Computes the table region of interest searched for cards.
+ *
+ * The region is centred in the frame and spans 80% of its width and 60% of its height.
+ *
+ * @param frame_size Size of the full video frame.
+ * @return Rectangle of the region of interest in frame coordinates.
+ */
+cv::Rect table_roi(const cv::Size &frame_size);
+
+/**
+ * @brief Runs card detection and recognition on a video using one thread per stage.
+ *
+ * The work done for each frame is split into five stages connected by bounded queues:
+ * - decode:   reads frames from `cap` and schedules keyframes with a StrideController; with
+ *             `config.decode_keyframes_only`, non-keyframes are only grabbed, not decoded;
+ * - detect:   motion gating, preprocessing, quadrilateral extraction and card tracking; cards
+ *             that are new or have moved are warped and their rank patch is submitted to a
+ *             micro-batching InferenceServer, while non-keyframes and keyframes without motion
+ *             reuse the results of the last keyframe;
+ * - classify: waits for the rank labels;
+ * - render:   Hi-Lo overlay drawing and prediction bookkeeping;
+ * - encode:   puts frames back in input order and hands them to an AsyncVideoWriter around
+ *             `writer`, if it is opened, which encodes them on its own thread.
+ *
+ * Unless `config.show_window` is false, frames are displayed on the calling thread, since
+ * HighGUI is not thread-safe, and pressing ESC in the window stops every stage. Without a
+ * window the run ends at the end of the stream or when `config.interrupted` is set; frames
+ * already decoded are still processed and written. With all stages running concurrently,
+ * throughput is bounded by the slowest stage rather than by the sum of all of them. Since the
+ * detect stage does not wait for the CNN, patches of several in-flight frames can share a
+ * forward pass.
+ *
+ * @param cap Opened video source.
+ * @param writer Video writer, or a writer that is not opened to skip writing.
+ * @param config Pipeline parameters.
+ * @param predictions Output map filled with the predictions of every processed frame.
+ * @return Timing statistics of the run.
+ */
+PipelineStats run_pipeline(cv::VideoCapture &cap, cv::VideoWriter &writer, const PipelineConfig &config, Predictions &predictions);
+
+/**
+ * @brief Prints throughput and the average busy time of each stage.
+ *
+ * @param stats Statistics returned by run_pipeline.
+ */
+void print_pipeline_stats(const PipelineStats &stats);
+
+#endif // PIPELINE_HPP
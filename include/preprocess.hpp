@@ -4,6 +4,7 @@
 #define PREPROCESS_HPP
 
 #include <opencv2/opencv.hpp>
+#include "rle_mask.hpp"
 
 /**
  * @brief Enhances a card image to make text and edges more legible for OCR.
@@ -17,18 +18,112 @@
  */
 void preprocessing_card(cv::Mat &image);
 
+/**
+ * @brief Runs the steps of preprocessing_card before the binarization.
+ *
+ * Converts to grayscale, applies CLAHE with `tiles` tiles, sharpens and blurs with a
+ * `blur_size` Gaussian kernel. The defaults are those of preprocessing_card.
+ *
+ * @param image Input/output cv::Mat, BGR initially and grayscale after processing.
+ * @param tiles Number of CLAHE tiles along each side.
+ * @param blur_size Size of the Gaussian blur kernel.
+ */
+void enhance_card(cv::Mat &image, const cv::Size &tiles = cv::Size(8, 8), const cv::Size &blur_size = cv::Size(9, 9));
+
+/**
+ * @brief Computes the mask of white-like pixels of a BGR image in a single pass.
+ *
+ * A pixel is white-like when it falls in the HSV range (0, 0, 245) - (180, 40, 255) used by
+ * preprocessing_image, i.e. its value V = max(B, G, R) is at least 245 and its 8-bit
+ * saturation is at most 40. Instead of converting to HSV, the saturation test is done on the
+ * channel spread max - min, with the per-V limits that reproduce OpenCV's fixed-point
+ * saturation exactly. Each row is processed with OpenCV universal intrinsics when available.
+ *
+ * @param image Input BGR image (CV_8UC3).
+ * @param mask Output mask (CV_8U), 255 for white-like pixels and 0 elsewhere.
+ */
+void white_mask(const cv::Mat &image, cv::Mat &mask);
+
+/**
+ * @brief Same as white_mask, encoded into runs as each row is thresholded.
+ *
+ * Only one row of the 8-bit mask exists at a time.
+ *
+ * @param image Input BGR image (CV_8UC3).
+ * @return Mask of the white-like pixels.
+ */
+RunMask white_mask_runs(const cv::Mat &image);
+
+/**
+ * @brief Fills the holes of the shapes in a binary mask.
+ *
+ * The background reachable from the image border is flood-filled with 4-connectivity, and
+ * every other pixel is set to 255. This covers the same pixels as filling the external
+ * contours found by `cv::findContours` with `cv::fillPoly`, without tracing any contour.
+ *
+ * @param mask Input/output binary mask (CV_8U, 0 or 255).
+ */
+void fill_holes(cv::Mat &mask);
+
+/**
+ * @brief Execution options of preprocessing_image. Every combination gives the same result.
+ */
+struct PreprocessOptions
+{
+    bool bit_packed = false; // Run the dilation, hole filling and erosion on a BitMask.
+    bool run_length = false; // Run the whole chain on a RunMask (see preprocessing_runs).
+    int bands = 1;           // Horizontal bands processed in parallel by the point-wise and morphological steps.
+    int downscale = 1;       // Reduction factor of the image w.r.t. full resolution; the kernels shrink with it.
+};
+
 /**
  * @brief Isolates bright, low-saturation regions (e.g. light beige or white areas)
  * within an image using an HSV-based mask and morphological operations.
  *
- * This function converts the input BGR image to HSV, thresholds to detect
- * "white-like" areas, applies dilation to close gaps, finds and fills external
- * contours, and then erodes to smooth shapes. The resulting image is binary,
+ * This function thresholds the input BGR image to detect "white-like" areas
+ * (see white_mask), applies dilation to close gaps, fills the holes of the
+ * shapes (see fill_holes), and then erodes to smooth shapes. The resulting image is binary,
  * where white-like regions are white (255) and the rest is black (0).
  *
+ * With `options.run_length`, the mask is built and processed as runs (see preprocessing_runs)
+ * and only decoded at the end. With `options.bit_packed`, the dilation, hole filling and erosion run on a BitMask with one
+ * bit per pixel instead of an 8-bit image. With `options.bands` greater than 1 (8-bit path
+ * only), the image is split into horizontal bands and the white mask, dilation and erosion of
+ * the bands run concurrently with `cv::parallel_for_`. Each band is filtered together with a
+ * halo of kernel_height / 2 rows from its neighbours (2 for the dilation, 7 for the erosion),
+ * so its rows match the whole-image result exactly. Hole filling needs the whole mask and
+ * stays serial between the two.
+ *
+ * For an image downscaled by `options.downscale`, the radii of the 5x5 dilation and 15x15
+ * erosion are divided by the same factor (e.g. 3x3 and 9x9 at half resolution).
+ *
+ * `touches` reports the shapes that may go on past the image when it is a patch of a larger
+ * one. A shape crossing a side of the patch can have its white pixels outside, as long as
+ * they lie within the dilation radius of that side, so its dilation first shows up within
+ * that radius. The strips of radius + 1 pixels along each side of the dilated mask are
+ * therefore checked before the holes are filled: past the erosion, a thin ring crossing a
+ * side may have vanished while its holes were filled without seeing all of it.
+ *
  * @param image Input/output cv::Mat representing the original image.
  * Must be a valid BGR image initially. After processing, it becomes grayscale binary.
+ * @param options How to run the mask operations.
+ * @param touches If not null, points to 4 values set to whether the dilated mask has set
+ * pixels along its left, top, right and bottom side.
+ */
+void preprocessing_image(cv::Mat &image, const PreprocessOptions &options = PreprocessOptions(), bool *touches = nullptr);
+
+/**
+ * @brief Same as preprocessing_image, producing the card mask as runs.
+ *
+ * The white mask is encoded row by row (see white_mask_runs), then the dilation, hole filling
+ * and erosion run on the runs. Past the threshold, the cost grows with the perimeter of the
+ * shapes instead of the number of pixels, and the result can be given to process() as is.
+ *
+ * @param image Input BGR image.
+ * @param options Only `options.downscale` is used.
+ * @param touches If not null, set as by preprocessing_image.
+ * @return The card mask.
  */
-void preprocessing_image(cv::Mat &image);
+RunMask preprocessing_runs(const cv::Mat &image, const PreprocessOptions &options = PreprocessOptions(), bool *touches = nullptr);
 
 #endif // PREPROCESS_HPP
\ No newline at end of file
@@ -5,6 +5,37 @@
 
 #include <opencv2/opencv.hpp>
 
+class RunMask;
+class WarpCache;
+
+/**
+ * @brief Size thresholds of the card detection, in pixels of the mask given to process().
+ *
+ * The defaults are tuned for full-resolution 1280x720 frames.
+ */
+struct ProcessParams
+{
+    double min_area = 3000;      // Minimum contour area of a card.
+    double min_perimeter = 250;  // Minimum contour perimeter of a card.
+    int pixel_tolerance = 7;     // Padding added outwards to each corner.
+    int peak_window = 25;        // Half window of the corner peak search, in contour points, or in
+                                 // pixels of arc length when contour_spacing is set.
+    double min_prominence = 10;  // Minimum prominence of a corner peak.
+    double contour_spacing = 0;  // Arc length between resampled contour points; 0 keeps every boundary pixel.
+};
+
+/**
+ * @brief Adapts the detection thresholds to a mask downscaled by `downscale` on each side.
+ *
+ * Areas shrink with the square of the factor, lengths, distances and contour point counts
+ * linearly. A nonzero contour spacing is kept at 1 pixel or more.
+ *
+ * @param params Thresholds at full resolution.
+ * @param downscale Reduction factor of the mask.
+ * @return Thresholds for the downscaled mask.
+ */
+ProcessParams scale_process_params(const ProcessParams &params, int downscale);
+
 /**
  * @brief Filters contours based on area and perimeter thresholds.
  *
@@ -56,6 +87,8 @@ double point_line_distance(const cv::Point &p, const cv::Point &p1, const cv::Po
  * This function scans through a vector of values and determines which elements
  * are local maxima within a specified window range. An element is considered a
  * local maximum if it is not smaller than any of its neighbors within the window.
+ * The window maxima and the side minima used for the prominence are computed with
+ * monotonic deques, so the cost is linear in the number of values whatever the window.
  *
  * @param distances    The vector of values in which to find local peaks.
  * @param window_size  Half-size of the window used to compare neighboring elements.
@@ -96,6 +129,7 @@ std::vector<std::pair<int, int>> pair_indices_symmetric(const std::vector<int> &
  * @param cards    A vector of contours (each a vector of cv::Point), representing the shapes of cards or regions.
  * @param ext_pts  A vector of external reference points for each contour. Each element must contain two points:
  *                 [0] is the bottom-left (bl) corner, [1] is the top-right (tr) corner.
+ * @param params   Corner padding and peak search thresholds.
  *
  * @return A vector of quadrilaterals (each a vector of 4 cv::Point elements), representing the detected regions
  *         in each contour. The order of points for each quadrilateral is:
@@ -103,11 +137,84 @@ std::vector<std::pair<int, int>> pair_indices_symmetric(const std::vector<int> &
  *
  * @note
  * - Corner points are slightly adjusted with a pixel tolerance to improve robustness.
- * - This function relies on helper functions `point_line_distance`, `find_local_maxima`, and
+ * - This function relies on helper functions `signed_line_distances`, `find_local_maxima`, and
  *   `pair_indices_symmetric`, which must be defined elsewhere.
  * - Debug information is printed to `std::cout`, indicating the number of extrema pairs found per contour.
  */
-std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<std::vector<cv::Point>> &cards, const std::vector<std::vector<cv::Point>> &ext_pts);
+std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<std::vector<cv::Point>> &cards, const std::vector<std::vector<cv::Point>> &ext_pts,
+                                                              const ProcessParams &params = ProcessParams());
+
+/**
+ * @brief Connected components of a binary mask and their statistics.
+ */
+struct MaskComponents
+{
+    cv::Mat labels; // CV_32S label of each pixel, 0 for the background.
+    cv::Mat stats;  // One row per label, with the cv::ConnectedComponentsTypes columns.
+    int count = 0;  // Number of labels, background included.
+};
+
+/**
+ * @brief Labels the 8-connected components of a binary mask.
+ *
+ * @param mask Binary mask (CV_8U), nonzero pixels being foreground.
+ * @return The label image and the bounding box and pixel area of every component.
+ */
+MaskComponents label_components(const cv::Mat &mask);
+
+/**
+ * @brief Connected component that may hold a card, with its statistics.
+ */
+struct BlobCandidate
+{
+    int label = 0;  // Label of the component in MaskComponents::labels.
+    cv::Rect box;   // Bounding box.
+    int area = 0;   // Number of pixels.
+};
+
+/**
+ * @brief Selects the connected components whose contour can enclose `min_area`, from their statistics alone.
+ *
+ * The contour of a component runs through the centres of its boundary pixels, so the polygon
+ * it encloses is smaller than both the pixel area and the (width - 1) x (height - 1) box
+ * spanned by those centres. Components failing either bound, such as the specks left by the
+ * white mask or thin markings, are dropped in O(1) each, without looking at their pixels.
+ *
+ * @param components Components of the mask (see label_components).
+ * @param min_area Minimum contour area of a card.
+ * @return The remaining components, by increasing label.
+ */
+std::vector<BlobCandidate> select_candidates(const MaskComponents &components, double min_area);
+
+/**
+ * @brief Traces the outer contour of the given connected components of a mask.
+ *
+ * Every candidate is traced inside its own bounding box, so the cost depends on the size of
+ * the candidates and not on the number of components in the mask. For a mask without holes,
+ * as produced by preprocessing_image, the result is the same as `cv::findContours` with
+ * RETR_EXTERNAL and `approximation` over the whole mask, restricted to the candidates, and in
+ * the same order.
+ *
+ * @param components Components of the mask (see label_components).
+ * @param candidates Components to trace (see select_candidates).
+ * @param approximation Contour approximation method, cv::CHAIN_APPROX_NONE or cv::CHAIN_APPROX_SIMPLE.
+ * @return One contour per traced component.
+ */
+std::vector<std::vector<cv::Point>> trace_components(const MaskComponents &components, const std::vector<BlobCandidate> &candidates,
+                                                     int approximation = cv::CHAIN_APPROX_NONE);
+
+/**
+ * @brief Resamples a closed contour at a constant arc length spacing.
+ *
+ * The samples are taken along the polygon formed by the contour points, starting at the first
+ * point, and rounded to the nearest pixel. A CHAIN_APPROX_SIMPLE contour, which only keeps the
+ * ends of the straight runs of boundary pixels, gives the same samples as the full contour.
+ *
+ * @param contour Closed contour.
+ * @param spacing Arc length between consecutive samples, in pixels.
+ * @return About arcLength(contour) / spacing points.
+ */
+std::vector<cv::Point> resample_contour(const std::vector<cv::Point> &contour, double spacing);
 
 /**
  * @brief Detects and extracts quadrilateral regions (e.g., cards) from a binary image.
@@ -118,8 +225,13 @@ std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<
  * by locating corner points and reordering contour data for consistent downstream processing.
  *
  * The method involves the following steps:
- * - Detect external contours in the binary image using OpenCV's `findContours`.
+ * - Label the connected components of the binary image and trace the external contour of
+ *   those whose area and bounding box are large enough for a card (see select_candidates
+ *   and trace_components).
  * - Filter out contours that do not meet minimum area and perimeter thresholds to retain only likely card shapes.
+ * - If `params.contour_spacing` is set, the contours are traced with CHAIN_APPROX_SIMPLE and
+ *   resampled at that spacing (see resample_contour), so that the corner search costs a number
+ *   of operations proportional to the perimeter divided by the spacing.
  * - For each valid contour:
  *    - Determine the two contour points closest to the image's bottom-left and top-right corners.
  *    - Save these external points as references for further corner refinement.
@@ -129,13 +241,48 @@ std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<
  *
  * @param image  Input image (`cv::Mat`), typically a binary (black and white) image.
  *               Must not be empty. The image is not modified directly.
+ * @param params Detection thresholds, scaled to the resolution of `image`.
  *
  * @return A vector of quadrilateral shapes (`std::vector<std::vector<cv::Point>>`),
  *         where each inner vector contains four points ordered as:
  *         bottom-left, bottom-right, top-right, top-left.
  *
  */
-std::vector<std::vector<cv::Point>> process(cv::Mat &image);
+std::vector<std::vector<cv::Point>> process(cv::Mat &image, const ProcessParams &params = ProcessParams());
+
+/**
+ * @brief Same as process(cv::Mat &), on a run-length encoded mask.
+ *
+ * The components are labelled and traced on the runs (see RunMask::label_components and
+ * RunMask::trace), so no pixel of the mask is visited and the cost grows with the perimeter of
+ * the shapes. The contours, hence the quads, are the same as for the decoded mask.
+ *
+ * @param mask Card mask, as produced by preprocessing_runs.
+ * @param params Detection thresholds, scaled to the resolution of `mask`.
+ * @return Quadrilaterals ordered as bottom-left, bottom-right, top-right, top-left.
+ */
+std::vector<std::vector<cv::Point>> process(const RunMask &mask, const ProcessParams &params = ProcessParams());
+
+/**
+ * @brief Maps quadrilaterals found by process() on a downscaled mask back to full resolution.
+ *
+ * The padding of each corner is removed, the corner is scaled up, and it is then refined
+ * in a small window of the full-resolution image: the white-like pixel (see white_mask)
+ * furthest out in the direction of the corner (e.g. down and to the left for bottom-left)
+ * replaces it, moved back by the 5 pixels that the dilation and erosion of
+ * preprocessing_image shrink a shape by. A corner whose furthest pixel lies on the edge of
+ * the window is not the corner of a white region (e.g. where two cards overlap) and keeps its
+ * scaled position. Finally the full-resolution padding is applied.
+ *
+ * @param image Full-resolution BGR image the mask was computed from.
+ * @param quads Quadrilaterals returned by process() on the downscaled mask, ordered as
+ *              bottom-left, bottom-right, top-right, top-left.
+ * @param downscale Reduction factor of the mask.
+ * @param params Thresholds at full resolution.
+ * @return The quadrilaterals in full-resolution coordinates.
+ */
+std::vector<std::vector<cv::Point>> upscale_quads(const cv::Mat &image, const std::vector<std::vector<cv::Point>> &quads, int downscale,
+                                                  const ProcessParams &params = ProcessParams());
 
 /**
  * @brief Sharpens the input image using a simple 3x3 convolution kernel.
@@ -161,6 +308,36 @@ void sharpen_image(cv::Mat &image);
  */
 void sort_corners(std::vector<cv::Point2f> &pts);
 
+/**
+ * @brief Clockwise rotation applied to a quadrilateral while it is warped to a rectangle.
+ *
+ * The value is the number of quarter turns.
+ */
+enum class CardOrientation
+{
+    Upright = 0,
+    Rotate90 = 1,
+    Rotate180 = 2,
+    Rotate270 = 3
+};
+
+/**
+ * @brief Computes the homography mapping a quadrilateral onto a rectangle.
+ *
+ * The corners of `quad` are ordered with sort_corners and mapped onto the corners of a
+ * `dstSize` rectangle. Upright maps top-left to (0, 0), top-right to (width - 1, 0), and so
+ * on; any other orientation permutes the destination corners, so the rotation is part of the
+ * homography instead of a second resampling pass. Rotate90 and Rotate270 turn a card lying
+ * sideways into a `dstSize` portrait image.
+ *
+ * @param quad Vector of 4 points representing the corners of the quadrilateral, in any order.
+ * @param dstSize The size (width, height) of the destination rectangle.
+ * @param orientation Clockwise rotation of the quadrilateral in the destination.
+ * @return 3x3 perspective transform (CV_64F) from source to destination coordinates.
+ */
+cv::Mat quad_to_rect_transform(const std::vector<cv::Point> &quad, const cv::Size &dstSize,
+                               CardOrientation orientation = CardOrientation::Upright);
+
 /**
  * @brief Applies a perspective transform to a quadrilateral region, warping it into a rectangle.
  *
@@ -172,22 +349,46 @@ void sort_corners(std::vector<cv::Point2f> &pts);
  * @param quad Vector of 4 points representing the corners of the quadrilateral region in the source image.
  *             The points do not need to be ordered; the function will order them internally.
  * @param dstSize The size (width, height) of the output warped image (rectangular).
+ * @param orientation Clockwise rotation of the region in the output (see quad_to_rect_transform).
  * @return The warped image containing the perspective-corrected rectangle.
  */
-cv::Mat warp_to_rect(const cv::Mat &src, const std::vector<cv::Point> &quad, const cv::Size &dstSize);
+cv::Mat warp_to_rect(const cv::Mat &src, const std::vector<cv::Point> &quad, const cv::Size &dstSize,
+                     CardOrientation orientation = CardOrientation::Upright);
 
 /**
  * @brief Warps and preprocesses card regions extracted from the source image.
  *
  * For each detected card-like quadrilateral contour, this function:
  * - Applies a perspective warp to obtain a front-facing rectangular image of fixed size.
- * - Rotates the card image by 180 degrees to ensure consistent orientation.
+ * - Rotates the card by 180 degrees within the same warp to ensure consistent orientation.
  * - Applies preprocessing (e.g., contrast enhancement, binarization) to prepare for OCR or further analysis.
  *
  * @param src The original full input image.
  * @param rects Vector of 4-point contours representing detected cards (quadrilaterals).
+ * @param cache Optional cache of remap tables, reused for cards that have not moved.
  * @return A vector of preprocessed card images, each warped and oriented consistently.
  */
-std::vector<cv::Mat> get_cards(const cv::Mat &src, const std::vector<std::vector<cv::Point>> &rects);
+std::vector<cv::Mat> get_cards(const cv::Mat &src, const std::vector<std::vector<cv::Point>> &rects, WarpCache *cache = nullptr);
+
+/**
+ * @brief Warps and preprocesses only the rank corner of each card.
+ *
+ * Approximates cropping the top-left `corner_size` region of the cards returned by get_cards
+ * without warping and filtering the whole 400x600 card:
+ * - the corner is warped over the CLAHE tiles its pixels are interpolated from (3x3 of the
+ *   8x8 tiles of 50x75 pixels for the rank window), so that CLAHE, sharpening and blur give
+ *   exactly the values of the whole card inside the window;
+ * - the Otsu threshold of the whole card is estimated on a 200x300 copy of the card, equalized
+ *   the same way with a 5x5 blur, and applied to the corner.
+ * Only the threshold can differ from get_cards, by the difference between the histograms of
+ * the two resolutions. This is about 2.5 times fewer pixels warped and filtered per card.
+ * The pipeline only uses it when asked to (`--rank-corners-only`).
+ *
+ * @param src The original full input image.
+ * @param rects Vector of 4-point contours representing detected cards (quadrilaterals).
+ * @param corner_size Size of the top-left window to extract (see rank_window_size).
+ * @return A vector of preprocessed `corner_size` card corners, one per rect.
+ */
+std::vector<cv::Mat> get_rank_corners(const cv::Mat &src, const std::vector<std::vector<cv::Point>> &rects, const cv::Size &corner_size);
 
 #endif // PROCESS_HPP
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef RENDER_HPP
+#define RENDER_HPP
+
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Draws the Hi-Lo overlay of every detected card onto a frame, in place.
+ *
+ * Each card quadrilateral is tinted with the color of its Hi-Lo value (see
+ * get_color_for_value), outlined, and labelled with its rank and count value. The tint is
+ * alpha-blended only inside the bounding box of the card, through a mask of the quad, so
+ * the cost grows with the card area instead of with card count x frame size. Cards are
+ * drawn in order, and the result is the same as blending a tinted copy of the whole frame
+ * once per card.
+ *
+ * @param frame BGR frame to annotate.
+ * @param rects Card quadrilaterals in frame coordinates.
+ * @param texts Rank label of each quadrilateral.
+ * @param alpha Opacity of the tint.
+ */
+void draw_card_overlays(cv::Mat &frame, const std::vector<std::vector<cv::Point>> &rects, const std::vector<std::string> &texts, double alpha = 0.3);
+
+#endif // RENDER_HPP
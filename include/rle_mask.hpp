@@ -0,0 +1,146 @@
+#ifndef RLE_MASK_HPP
+#define RLE_MASK_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Connected components of a RunMask (see RunMask::label_components).
+ */
+struct RunComponents
+{
+    std::vector<int> run_labels; // Label of each run of the mask, from 1.
+    std::vector<cv::Rect> boxes; // Bounding box of the component labelled k, at index k - 1.
+    std::vector<int> areas;      // Number of pixels of the component labelled k, at index k - 1.
+
+    int count() const { return static_cast<int>(boxes.size()); }
+};
+
+/**
+ * @brief Binary mask stored as the runs of set pixels of each row.
+ *
+ * The card mask is made of a few large, convex-ish shapes, so a row holds a handful of runs
+ * whatever the width of the image. Every operation below walks the runs instead of the pixels,
+ * and costs O(runs), i.e. grows with the perimeter of the shapes rather than with their area:
+ * - dilate() and erode() move the ends of the runs of each row, then merge or intersect the
+ *   runs of the rows covered by the kernel;
+ * - fill_holes() and label_components() join the gaps or runs of adjacent rows that overlap
+ *   with a union-find;
+ * - trace() follows the outer border of a component, looking up its pixels by binary search
+ *   among the runs of their row.
+ *
+ * Every operation gives the same result as its OpenCV counterpart on a 0/255 `cv::Mat`, as
+ * BitMask does.
+ */
+class RunMask
+{
+public:
+    /**
+     * @brief Pixels [start, end) of a row.
+     */
+    struct Run
+    {
+        int start;
+        int end;
+    };
+
+    RunMask() = default;
+
+    /**
+     * @brief Creates a mask of the given size with every pixel cleared.
+     */
+    explicit RunMask(const cv::Size &size);
+
+    /**
+     * @brief Encodes a CV_8U image, setting the pixels that are nonzero.
+     */
+    static RunMask from_mat(const cv::Mat &mask);
+
+    /**
+     * @brief Decodes the mask into a CV_8U image holding 0 or 255.
+     */
+    void to_mat(cv::Mat &mask) const;
+
+    cv::Size size() const;
+
+    /**
+     * @brief Number of set pixels.
+     */
+    size_t count() const;
+
+    /**
+     * @brief Number of set pixels inside `area`.
+     */
+    size_t count(const cv::Rect &area) const;
+
+    /**
+     * @brief Number of runs over all the rows.
+     */
+    size_t run_count() const;
+
+    /**
+     * @brief Appends a row to a mask built row by row from RunMask(cv::Size(width, 0)).
+     *
+     * @param pixels `width` values, the nonzero ones being set.
+     */
+    void push_row(const uchar *pixels);
+
+    /**
+     * @brief Dilation with a `kernel_size` rectangle centred on each pixel (see cv::dilate).
+     */
+    RunMask dilate(const cv::Size &kernel_size) const;
+
+    /**
+     * @brief Erosion with a `kernel_size` rectangle centred on each pixel (see cv::erode).
+     */
+    RunMask erode(const cv::Size &kernel_size) const;
+
+    /**
+     * @brief Sets every cleared pixel that is not 4-connected to the border by cleared pixels.
+     *
+     * Same result as fill_holes on the decoded mask.
+     */
+    void fill_holes();
+
+    /**
+     * @brief Replaces the pixels of `area` with those of `patch` starting at `patch_origin`.
+     */
+    void paste(const cv::Rect &area, const RunMask &patch, const cv::Point &patch_origin);
+
+    /**
+     * @brief Labels the 8-connected components, by order of their first pixel in raster order.
+     *
+     * The boxes and areas are those given by `cv::connectedComponentsWithStats`.
+     */
+    RunComponents label_components() const;
+
+    /**
+     * @brief Outer border of the component labelled `label`.
+     *
+     * The points, their order and the starting point are those of `cv::findContours` with
+     * RETR_EXTERNAL on a mask holding only this component: the Suzuki-Abe border following
+     * that OpenCV implements, started from the first pixel of the component in raster order.
+     *
+     * @param components Components of this mask.
+     * @param label Component to trace, from 1 to components.count().
+     * @param approximation cv::CHAIN_APPROX_NONE or cv::CHAIN_APPROX_SIMPLE.
+     */
+    std::vector<cv::Point> trace(const RunComponents &components, int label, int approximation = cv::CHAIN_APPROX_NONE) const;
+
+private:
+    const Run *row_begin(int y) const;
+    const Run *row_end(int y) const;
+
+    // Appends a row made of sorted runs; runs that touch are merged
+    void append_row(const std::vector<Run> &runs);
+
+    // Index of the run of row y holding pixel x, or -1
+    int find_run(int x, int y) const;
+
+    int rows_ = 0;
+    int cols_ = 0;
+    std::vector<Run> runs_;
+    std::vector<int> row_start_ = {0}; // Runs of row y are [row_start_[y], row_start_[y + 1]).
+};
+
+#endif // RLE_MASK_HPP
@@ -0,0 +1,15 @@
+#ifndef SIMD_CONFIG_HPP
+#define SIMD_CONFIG_HPP
+
+#include <opencv2/core/version.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+/**
+ * @brief Whether the function forms of the OpenCV universal intrinsics (v_add, VTraits, ...) exist.
+ *
+ * They appeared in OpenCV 4.8. The SIMD kernels are guarded by this and by `CV_SIMD` or
+ * `CV_SIMD_SCALABLE`; older releases and builds without SIMD run the scalar loops.
+ */
+#define HAS_INTRINSIC_FUNCTIONS (CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 8))
+
+#endif // SIMD_CONFIG_HPP
@@ -0,0 +1,95 @@
+#ifndef STRIDE_CONTROLLER_HPP
+#define STRIDE_CONTROLLER_HPP
+
+#include <mutex>
+
+/**
+ * @brief Chooses which frames run card detection so as to hold a per-frame latency budget.
+ *
+ * Every `stride`-th frame is a keyframe. The cost of each keyframe (detection plus
+ * classification) is reported through record(), and the cost of each frame in between
+ * (moving the quads along, or detecting when tracking was lost) through record_intermediate().
+ * Both are smoothed with an exponential moving average. In adaptive mode the stride is then
+ * set to the smallest value in [1, max_stride] whose amortized cost per frame,
+ * (keyframe cost + (stride - 1) * intermediate cost) / stride, fits in the target latency, or
+ * to the cheapest one if none does. An idle table is therefore checked every frame, while a
+ * busy one is sampled less often.
+ *
+ * All methods are thread-safe: frames are scheduled by the decode stage while their costs
+ * are reported by the classify stage.
+ */
+class StrideController
+{
+public:
+    /**
+     * @param target_latency_ms Detection time allowed per frame, e.g. 33 ms at 30 FPS.
+     * @param max_stride Largest stride the adaptive controller may choose.
+     * @param initial_stride Stride used until the first keyframe cost is known, or always if not adaptive
+     * (then not limited by `max_stride`).
+     * @param adaptive Whether the stride follows the measured keyframe cost.
+     * @param smoothing Weight of the newest sample in the moving average of the keyframe cost.
+     */
+    StrideController(double target_latency_ms, int max_stride, int initial_stride, bool adaptive, double smoothing = 0.2);
+
+    /**
+     * @brief Advances to the next frame.
+     *
+     * @return true if the frame is a keyframe.
+     */
+    bool next_frame();
+
+    /**
+     * @brief Reports the time spent detecting and classifying on a keyframe.
+     *
+     * @param keyframe_ms Cost of the keyframe in milliseconds.
+     */
+    void record(double keyframe_ms);
+
+    /**
+     * @brief Reports the time spent on a frame between two keyframes.
+     *
+     * @param frame_ms Cost of the frame in milliseconds.
+     */
+    void record_intermediate(double frame_ms);
+
+    /**
+     * @brief Current stride.
+     */
+    int stride() const;
+
+    /**
+     * @brief Smoothed cost of a keyframe, in milliseconds.
+     */
+    double keyframe_latency_ms() const;
+
+    /**
+     * @brief Smoothed cost of a frame between two keyframes, in milliseconds.
+     */
+    double intermediate_latency_ms() const;
+
+    /**
+     * @brief Smoothed cost amortized over the frames of one stride, in milliseconds.
+     */
+    double frame_latency_ms() const;
+
+private:
+    // Mean cost per frame of a keyframe followed by stride - 1 intermediate frames
+    double amortized_ms(int stride) const;
+
+    // Picks the stride from the smoothed costs; the mutex must be held
+    void update_stride();
+
+    double target_latency_ms_;
+    int max_stride_;
+    bool adaptive_;
+    double smoothing_;
+    int stride_;
+    int since_keyframe_;
+    bool has_sample_ = false;
+    bool has_intermediate_sample_ = false;
+    double keyframe_ms_ = 0.0;
+    double intermediate_ms_ = 0.0;
+    mutable std::mutex mutex_;
+};
+
+#endif // STRIDE_CONTROLLER_HPP
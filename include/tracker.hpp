@@ -0,0 +1,73 @@
+#ifndef TRACKER_HPP
+#define TRACKER_HPP
+
+#include <future>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief A card followed across detection keyframes.
+ */
+struct CardTrack
+{
+    int id = 0;
+    std::vector<cv::Point> quad;             // Quad matched on the latest keyframe.
+    std::vector<cv::Point> classified_quad;  // Quad at the time the card was last classified.
+    std::shared_future<std::string> label;   // Rank label, valid once the card has been classified.
+    bool rejected = false;                   // The rank patch failed validation; not a card.
+    int missed = 0;                          // Consecutive keyframes without a matching quad.
+};
+
+/**
+ * @brief Associates card quads across keyframes and decides which cards need classifying.
+ *
+ * Quads returned by `process()` are matched to existing tracks greedily, by bounding-box IoU
+ * (see compute_iou) or, failing that, by centroid distance. Matched tracks keep their ID and
+ * their label; unmatched quads open new tracks, and tracks that go unmatched for more than
+ * `max_missed` keyframes are dropped.
+ *
+ * A track only needs to be warped and classified again when it is new or when one of its
+ * corners has moved more than `move_threshold` pixels since its last classification. Since
+ * dealt cards usually stay still for many seconds, this skips most CNN calls.
+ */
+class CardTracker
+{
+public:
+    /**
+     * @param min_iou Minimum bounding-box IoU for a quad to continue a track.
+     * @param max_centroid_distance Maximum centroid distance (pixels) for a quad to continue a track.
+     * @param move_threshold Corner displacement (pixels) after which a track is classified again.
+     * @param max_missed Number of keyframes a track survives without a matching quad.
+     */
+    CardTracker(double min_iou = 0.5, double max_centroid_distance = 15.0, double move_threshold = 6.0, int max_missed = 2);
+
+    /**
+     * @brief Matches the quads of a new keyframe to the current tracks.
+     *
+     * @param quads Card quadrilaterals detected on the keyframe.
+     * @return One track per quad, in the same order. The pointers stay valid until the next call
+     *         to update() or clear().
+     */
+    std::vector<CardTrack *> update(const std::vector<std::vector<cv::Point>> &quads);
+
+    /**
+     * @brief Whether the card of a track must be warped and classified on this keyframe.
+     */
+    bool needs_classification(const CardTrack &track) const;
+
+    /**
+     * @brief Drops every track, forcing all cards to be classified again.
+     */
+    void clear();
+
+private:
+    double min_iou_;
+    double max_centroid_distance_;
+    double move_threshold_;
+    int max_missed_;
+    int next_id_ = 0;
+    std::vector<CardTrack> tracks_;
+};
+
+#endif // TRACKER_HPP
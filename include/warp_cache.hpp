@@ -0,0 +1,81 @@
+#ifndef WARP_CACHE_HPP
+#define WARP_CACHE_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "process.hpp"
+
+/**
+ * @brief Caches the fixed-point remap tables of card warps whose quadrilateral does not move.
+ *
+ * `cv::warpPerspective` projects every destination pixel through the homography on each call,
+ * even when a card lies still on the table and the homography is the same as on the previous
+ * keyframe. The cache stores, for each warped quadrilateral, the source coordinates of the
+ * destination pixels converted once with `cv::convertMaps` to the CV_16SC2 + CV_16UC1 format
+ * (integer coordinates plus interpolation table index), which `cv::remap` consumes without any
+ * per-pixel projection or float-to-fixed conversion.
+ *
+ * An entry is reused while every corner of the new quadrilateral is within `tolerance` pixels
+ * of the cached one, with the same output size and orientation. Entries unused for more than
+ * `max_age` frames (see next_frame()) are evicted.
+ *
+ * The pipeline only uses the cache without card tracking (`--no-tracking`): with tracking,
+ * a card is only warped again once a corner has moved past the tracker threshold, far outside
+ * `tolerance`, so the tables would never be reused. An entry holds the tables of a whole
+ * 400x600 card (see get_cards), about 1.4 MB.
+ */
+class WarpCache
+{
+public:
+    /**
+     * @param tolerance Largest corner displacement, in pixels, for which cached tables are reused.
+     * @param max_age Number of frames an unused entry is kept for.
+     */
+    explicit WarpCache(double tolerance = 1.0, int max_age = 4);
+
+    /**
+     * @brief Warps a quadrilateral of `src` into a `card_size` rectangle, like warp_to_rect.
+     *
+     * @param src The input source image.
+     * @param quad Vector of 4 points representing the corners of the quadrilateral, in any order.
+     * @param card_size Size of the output rectangle.
+     * @param orientation Clockwise rotation of the quadrilateral in the output.
+     * @param dst Output warped image.
+     */
+    void warp(const cv::Mat &src, const std::vector<cv::Point> &quad, const cv::Size &card_size, CardOrientation orientation, cv::Mat &dst);
+
+    /**
+     * @brief Starts a new frame and evicts the entries unused for more than `max_age` frames.
+     */
+    void next_frame();
+
+    /**
+     * @brief Number of warps served from cached tables.
+     */
+    size_t hits() const;
+
+    /**
+     * @brief Number of warps that had to build new tables.
+     */
+    size_t misses() const;
+
+private:
+    struct Entry
+    {
+        std::vector<cv::Point2f> corners; // Sorted corners of the quadrilateral.
+        cv::Size card_size;
+        CardOrientation orientation;
+        cv::Mat map_xy;  // CV_16SC2 integer source coordinates.
+        cv::Mat map_idx; // CV_16UC1 interpolation table index.
+        int last_used;
+    };
+
+    double tolerance_;
+    int max_age_;
+    int frame_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    std::vector<Entry> entries_;
+};
+
+#endif // WARP_CACHE_HPP
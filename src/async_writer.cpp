@@ -0,0 +1,100 @@
+#include "async_writer.hpp"
+
+#include <chrono>
+
+AsyncVideoWriter::AsyncVideoWriter(cv::VideoWriter &writer, const cv::Size &frame_size, int frame_type, size_t capacity, OverflowPolicy policy)
+    : writer_(writer), policy_(policy)
+{
+    slots_.reserve(std::max<size_t>(1, capacity));
+    for (size_t i = 0; i < std::max<size_t>(1, capacity); ++i)
+        slots_.emplace_back(frame_size, frame_type);
+
+    worker_ = std::thread(&AsyncVideoWriter::run, this);
+}
+
+AsyncVideoWriter::~AsyncVideoWriter()
+{
+    close();
+}
+
+bool AsyncVideoWriter::write(const cv::Mat &frame)
+{
+    size_t tail;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (count_ == slots_.size() && policy_ == OverflowPolicy::Drop)
+        {
+            dropped_++;
+            return false;
+        }
+        not_full_.wait(lock, [this]
+                       { return closed_ || count_ < slots_.size(); });
+        if (closed_)
+            return false;
+        tail = (head_ + count_) % slots_.size();
+    }
+
+    // The slot is not visible to the encoder until count_ is incremented, so copy without the lock.
+    // copyTo only reallocates if the frame size or type differs from the preallocated one.
+    frame.copyTo(slots_[tail]);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count_++;
+    }
+    not_empty_.notify_one();
+    return true;
+}
+
+void AsyncVideoWriter::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+size_t AsyncVideoWriter::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+double AsyncVideoWriter::encode_ms() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return encode_ms_;
+}
+
+void AsyncVideoWriter::run()
+{
+    while (true)
+    {
+        size_t head;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this]
+                            { return closed_ || count_ > 0; });
+            // Frames still in the ring are flushed before stopping
+            if (count_ == 0)
+                return;
+            head = head_;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        writer_.write(slots_[head]);
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            head_ = (head_ + 1) % slots_.size();
+            count_--;
+            encode_ms_ += elapsed;
+        }
+        not_full_.notify_one();
+    }
+}
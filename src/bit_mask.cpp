@@ -0,0 +1,271 @@
+#include "bit_mask.hpp"
+
+#include <bitset>
+
+static const int WORD_BITS = 64;
+
+// dst |= src moved by `dx` pixels, i.e. dst pixel x receives src pixel x + dx (0 outside the row).
+static void or_shifted(const uint64_t *src, uint64_t *dst, int words, int dx)
+{
+    int q = std::abs(dx) / WORD_BITS;
+    int r = std::abs(dx) % WORD_BITS;
+    for (int i = 0; i < words; i++)
+    {
+        int j = dx >= 0 ? i + q : i - q;
+        uint64_t near_word = (j >= 0 && j < words) ? src[j] : 0;
+        uint64_t word;
+        if (dx >= 0)
+        {
+            uint64_t far_word = (j + 1 < words) ? src[j + 1] : 0;
+            word = r == 0 ? near_word : (near_word >> r) | (far_word << (WORD_BITS - r));
+        }
+        else
+        {
+            uint64_t far_word = (j - 1 >= 0 && j - 1 < words) ? src[j - 1] : 0;
+            word = r == 0 ? near_word : (near_word << r) | (far_word >> (WORD_BITS - r));
+        }
+        dst[i] |= word;
+    }
+}
+
+// Kogge-Stone occluded fills: spreads the seeds `s` through the runs of `p` they belong to,
+// towards the higher bits (fill_up) or the lower bits (fill_down) of the word.
+static uint64_t fill_up(uint64_t s, uint64_t p)
+{
+    s &= p;
+    s |= p & (s << 1);
+    p &= p << 1;
+    s |= p & (s << 2);
+    p &= p << 2;
+    s |= p & (s << 4);
+    p &= p << 4;
+    s |= p & (s << 8);
+    p &= p << 8;
+    s |= p & (s << 16);
+    p &= p << 16;
+    s |= p & (s << 32);
+    return s;
+}
+
+static uint64_t fill_down(uint64_t s, uint64_t p)
+{
+    s &= p;
+    s |= p & (s >> 1);
+    p &= p >> 1;
+    s |= p & (s >> 2);
+    p &= p >> 2;
+    s |= p & (s >> 4);
+    p &= p >> 4;
+    s |= p & (s >> 8);
+    p &= p >> 8;
+    s |= p & (s >> 16);
+    p &= p >> 16;
+    s |= p & (s >> 32);
+    return s;
+}
+
+// Spreads the seeds of a row along its runs of passable pixels, across word boundaries.
+static void fill_row(uint64_t *seeds, const uint64_t *passable, int words)
+{
+    for (int i = 0; i < words; i++)
+    {
+        if (i > 0 && (seeds[i - 1] >> (WORD_BITS - 1)) & 1)
+            seeds[i] |= passable[i] & 1;
+        seeds[i] = fill_up(seeds[i], passable[i]);
+    }
+    for (int i = words - 1; i >= 0; i--)
+    {
+        if (i < words - 1 && (seeds[i + 1] & 1))
+            seeds[i] |= passable[i] & (uint64_t(1) << (WORD_BITS - 1));
+        seeds[i] = fill_down(seeds[i], passable[i]);
+    }
+}
+
+BitMask::BitMask(const cv::Size &size)
+    : rows_(size.height), cols_(size.width), words_((size.width + WORD_BITS - 1) / WORD_BITS)
+{
+    bits_.assign(static_cast<size_t>(rows_) * words_, 0);
+}
+
+BitMask BitMask::from_mat(const cv::Mat &mask)
+{
+    CV_Assert(mask.type() == CV_8U);
+    BitMask packed(mask.size());
+    for (int y = 0; y < packed.rows_; y++)
+    {
+        const uchar *src = mask.ptr<uchar>(y);
+        uint64_t *dst = packed.row(y);
+        for (int x = 0; x < packed.cols_; x++)
+            dst[x / WORD_BITS] |= uint64_t(src[x] != 0) << (x % WORD_BITS);
+    }
+    return packed;
+}
+
+void BitMask::to_mat(cv::Mat &mask) const
+{
+    mask.create(size(), CV_8U);
+    for (int y = 0; y < rows_; y++)
+    {
+        const uint64_t *src = row(y);
+        uchar *dst = mask.ptr<uchar>(y);
+        for (int x = 0; x < cols_; x++)
+            dst[x] = ((src[x / WORD_BITS] >> (x % WORD_BITS)) & 1) ? 255 : 0;
+    }
+}
+
+cv::Size BitMask::size() const
+{
+    return cv::Size(cols_, rows_);
+}
+
+size_t BitMask::count() const
+{
+    size_t total = 0;
+    for (uint64_t word : bits_)
+        total += std::bitset<WORD_BITS>(word).count();
+    return total;
+}
+
+size_t BitMask::count(const cv::Rect &area) const
+{
+    cv::Rect r = area & cv::Rect(0, 0, cols_, rows_);
+    size_t total = 0;
+    for (int y = r.y; y < r.y + r.height; y++)
+    {
+        const uint64_t *words = row(y);
+        for (int x = r.x; x < r.x + r.width; x++)
+            total += (words[x / WORD_BITS] >> (x % WORD_BITS)) & 1;
+    }
+    return total;
+}
+
+BitMask BitMask::dilate(const cv::Size &kernel_size) const
+{
+    // A rectangle is separable: rows first, then columns. The anchor is the kernel centre.
+    int ax = kernel_size.width / 2, ay = kernel_size.height / 2;
+
+    BitMask horizontal(size());
+    for (int y = 0; y < rows_; y++)
+        for (int dx = -ax; dx < kernel_size.width - ax; dx++)
+            or_shifted(row(y), horizontal.row(y), words_, dx);
+    horizontal.clear_padding();
+
+    BitMask result(size());
+    for (int y = 0; y < rows_; y++)
+    {
+        uint64_t *dst = result.row(y);
+        int y0 = std::max(0, y - ay), y1 = std::min(rows_ - 1, y + kernel_size.height - 1 - ay);
+        for (int sy = y0; sy <= y1; sy++)
+        {
+            const uint64_t *src = horizontal.row(sy);
+            for (int i = 0; i < words_; i++)
+                dst[i] |= src[i];
+        }
+    }
+    return result;
+}
+
+BitMask BitMask::erode(const cv::Size &kernel_size) const
+{
+    // Erosion with pixels outside set is the complement of the dilation of the complement
+    // with pixels outside cleared
+    BitMask complement = *this;
+    complement.invert();
+    BitMask result = complement.dilate(kernel_size);
+    result.invert();
+    return result;
+}
+
+void BitMask::fill_holes()
+{
+    if (bits_.empty())
+        return;
+
+    BitMask passable = *this;
+    passable.invert();
+
+    // Seeds: the cleared pixels on the border
+    BitMask reached(size());
+    for (int y = 0; y < rows_; y++)
+    {
+        const uint64_t *p = passable.row(y);
+        uint64_t *s = reached.row(y);
+        if (y == 0 || y == rows_ - 1)
+        {
+            std::copy(p, p + words_, s);
+        }
+        else
+        {
+            s[0] |= p[0] & 1;
+            int last = cols_ - 1;
+            s[last / WORD_BITS] |= p[last / WORD_BITS] & (uint64_t(1) << (last % WORD_BITS));
+        }
+        fill_row(s, p, words_);
+    }
+
+    // Alternate downward and upward sweeps until no row gains a reached pixel
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int k = 1; k < rows_; k++)
+            {
+                int y = pass == 0 ? k : rows_ - 1 - k;
+                int from = pass == 0 ? y - 1 : y + 1;
+                const uint64_t *p = passable.row(y);
+                const uint64_t *neighbour = reached.row(from);
+                uint64_t *s = reached.row(y);
+
+                bool grown = false;
+                for (int i = 0; i < words_; i++)
+                {
+                    uint64_t gained = neighbour[i] & p[i] & ~s[i];
+                    if (gained)
+                    {
+                        s[i] |= gained;
+                        grown = true;
+                    }
+                }
+                if (grown)
+                {
+                    fill_row(s, p, words_);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Everything the border cannot reach is either a shape or one of its holes
+    reached.invert();
+    bits_ = std::move(reached.bits_);
+}
+
+uint64_t *BitMask::row(int y)
+{
+    return bits_.data() + static_cast<size_t>(y) * words_;
+}
+
+const uint64_t *BitMask::row(int y) const
+{
+    return bits_.data() + static_cast<size_t>(y) * words_;
+}
+
+void BitMask::clear_padding()
+{
+    int used = cols_ % WORD_BITS;
+    if (used == 0 || words_ == 0)
+        return;
+
+    uint64_t keep = (uint64_t(1) << used) - 1;
+    for (int y = 0; y < rows_; y++)
+        row(y)[words_ - 1] &= keep;
+}
+
+void BitMask::invert()
+{
+    for (uint64_t &word : bits_)
+        word = ~word;
+    clear_padding();
+}
@@ -0,0 +1,97 @@
+#include "contour_geometry.hpp"
+#include "simd_config.hpp"
+
+void split_contour(const std::vector<cv::Point> &contour, ContourCoords &coords)
+{
+    coords.x.resize(contour.size());
+    coords.y.resize(contour.size());
+    for (size_t i = 0; i < contour.size(); i++)
+    {
+        coords.x[i] = contour[i].x;
+        coords.y[i] = contour[i].y;
+    }
+}
+
+void squared_distances(const ContourCoords &coords, const cv::Point &target, std::vector<int> &distances)
+{
+    int n = coords.size();
+    distances.resize(n);
+    const int *xs = coords.x.data();
+    const int *ys = coords.y.data();
+    int *dst = distances.data();
+
+    int i = 0;
+#if HAS_INTRINSIC_FUNCTIONS && (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = cv::VTraits<cv::v_int32>::vlanes();
+    const cv::v_int32 tx = cv::vx_setall_s32(target.x);
+    const cv::v_int32 ty = cv::vx_setall_s32(target.y);
+    for (; i <= n - lanes; i += lanes)
+    {
+        cv::v_int32 dx = cv::v_sub(cv::vx_load(xs + i), tx);
+        cv::v_int32 dy = cv::v_sub(cv::vx_load(ys + i), ty);
+        cv::v_store(dst + i, cv::v_add(cv::v_mul(dx, dx), cv::v_mul(dy, dy)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        int dx = xs[i] - target.x;
+        int dy = ys[i] - target.y;
+        dst[i] = dx * dx + dy * dy;
+    }
+}
+
+void signed_line_distances(const ContourCoords &coords, const cv::Point &p1, const cv::Point &p2, double line_length,
+                           std::vector<double> &distances)
+{
+    int n = coords.size();
+    distances.resize(n);
+    const int *xs = coords.x.data();
+    const int *ys = coords.y.data();
+    double *dst = distances.data();
+    int ax = p2.x - p1.x, ay = p2.y - p1.y;
+
+    int i = 0;
+#if HAS_INTRINSIC_FUNCTIONS && (CV_SIMD_64F || CV_SIMD_SCALABLE_64F)
+    const int lanes = cv::VTraits<cv::v_int32>::vlanes();
+    const int half = cv::VTraits<cv::v_float64>::vlanes();
+    const cv::v_int32 x0 = cv::vx_setall_s32(p1.x), y0 = cv::vx_setall_s32(p1.y);
+    const cv::v_int32 vax = cv::vx_setall_s32(ax), vay = cv::vx_setall_s32(ay);
+    const cv::v_float64 length = cv::vx_setall_f64(line_length);
+    for (; i <= n - lanes; i += lanes)
+    {
+        // Integer cross products are exact; divide (not multiply by the inverse) to round as the scalar path
+        cv::v_int32 cross = cv::v_sub(cv::v_mul(cv::v_sub(cv::vx_load(xs + i), x0), vay),
+                                      cv::v_mul(cv::v_sub(cv::vx_load(ys + i), y0), vax));
+        cv::v_store(dst + i, cv::v_div(cv::v_cvt_f64(cross), length));
+        cv::v_store(dst + i + half, cv::v_div(cv::v_cvt_f64_high(cross), length));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = static_cast<double>((xs[i] - p1.x) * ay - (ys[i] - p1.y) * ax) / line_length;
+}
+
+// Finds the smallest value with vector min, then the first index holding it
+int argmin(const std::vector<int> &values)
+{
+    int n = static_cast<int>(values.size());
+    if (n == 0)
+        return -1;
+
+    const int *src = values.data();
+    int best = src[0];
+    int i = 0;
+#if HAS_INTRINSIC_FUNCTIONS && (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = cv::VTraits<cv::v_int32>::vlanes();
+    if (n >= lanes)
+    {
+        cv::v_int32 acc = cv::vx_load(src);
+        for (i = lanes; i <= n - lanes; i += lanes)
+            acc = cv::v_min(acc, cv::vx_load(src + i));
+        best = cv::v_reduce_min(acc);
+    }
+#endif
+    for (; i < n; i++)
+        best = std::min(best, src[i]);
+
+    return static_cast<int>(std::find(values.begin(), values.end(), best) - values.begin());
+}
@@ -0,0 +1,96 @@
+#include "corner_propagator.hpp"
+#include "motion.hpp"
+
+CornerPropagator::CornerPropagator(int downscale, const cv::Size &window, int levels, double max_error, double min_confidence)
+    : downscale_(std::max(1, downscale)), window_(window), levels_(std::max(0, levels)), max_error_(max_error), min_confidence_(min_confidence)
+{
+}
+
+void CornerPropagator::reset(const cv::Mat &roi, const std::vector<std::vector<cv::Point>> &quads)
+{
+    small_gray(roi, downscale_, previous_);
+
+    // Pixel centres line up: full pixel x covers small pixels (x + 0.5) / downscale - 0.5
+    corners_.clear();
+    double f = downscale_;
+    for (const auto &quad : quads)
+        for (const auto &pt : quad)
+            corners_.emplace_back(static_cast<float>((pt.x + 0.5) / f - 0.5), static_cast<float>((pt.y + 0.5) / f - 0.5));
+    confidence_ = 1.0;
+}
+
+bool CornerPropagator::propagate(const cv::Mat &roi, std::vector<std::vector<cv::Point>> &quads)
+{
+    quads.clear();
+    cv::Mat current;
+    small_gray(roi, downscale_, current);
+    if (previous_.empty() || current.size() != previous_.size())
+        return false;
+    if (corners_.empty())
+    {
+        previous_ = current;
+        confidence_ = 1.0;
+        return true;
+    }
+
+    // Forward to the new frame, then back: a corner that does not come back is not trusted
+    std::vector<cv::Point2f> next, back;
+    std::vector<uchar> status, back_status;
+    std::vector<float> error;
+    cv::TermCriteria criteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03);
+    cv::calcOpticalFlowPyrLK(previous_, current, corners_, next, status, error, window_, levels_, criteria);
+    cv::calcOpticalFlowPyrLK(current, previous_, next, back, back_status, error, window_, levels_, criteria);
+
+    size_t trusted_total = 0;
+    bool lost = false;
+    for (size_t q = 0; q + 4 <= corners_.size(); q += 4)
+    {
+        bool trusted[4];
+        int count = 0;
+        cv::Point2f shift(0.0f, 0.0f);
+        for (int k = 0; k < 4; k++)
+        {
+            size_t i = q + k;
+            trusted[k] = status[i] && back_status[i] && cv::norm(back[i] - corners_[i]) <= max_error_;
+            if (trusted[k])
+            {
+                count++;
+                shift += next[i] - corners_[i];
+            }
+        }
+        trusted_total += count;
+
+        if (count < 3)
+        {
+            lost = true;
+            continue;
+        }
+        // A single lost corner follows the rest of the card
+        for (int k = 0; k < 4; k++)
+        {
+            if (!trusted[k])
+                next[q + k] = corners_[q + k] + shift * (1.0f / count);
+        }
+    }
+
+    confidence_ = static_cast<double>(trusted_total) / corners_.size();
+    if (lost || confidence_ < min_confidence_)
+        return false;
+
+    previous_ = current;
+    corners_ = next;
+    double f = downscale_;
+    for (size_t q = 0; q + 4 <= corners_.size(); q += 4)
+    {
+        std::vector<cv::Point> quad;
+        for (size_t i = q; i < q + 4; i++)
+            quad.emplace_back(cvRound((corners_[i].x + 0.5) * f - 0.5), cvRound((corners_[i].y + 0.5) * f - 0.5));
+        quads.push_back(quad);
+    }
+    return true;
+}
+
+double CornerPropagator::confidence() const
+{
+    return confidence_;
+}
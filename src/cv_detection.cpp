@@ -4,10 +4,141 @@
 #include "process.hpp"
 #include "detect.hpp"
 #include "evaluation.hpp"
+#include "pipeline.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+
+static std::atomic<bool> interrupted(false);
+
+static void handle_signal(int)
+{
+    interrupted = true;
+}
+
+static void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " [input_video] [--headless] [--no-video] [--offline-stride N] [--drop-frames]\n"
+              << "       [--detection-scale N] [--contour-spacing PX] [--no-tracking]\n"
+              << "       [--bit-packed-masks] [--preprocess-bands N]\n"
+              << "       [--run-length-masks] [--rank-corners-only]\n"
+              << "  --headless          Run without any window; stop at end of stream or on SIGINT/SIGTERM\n"
+              << "  --no-video          Do not write output.mp4\n"
+              << "  --offline-stride N  Detect on every N-th frame and only grab the others (implies\n"
+              << "                      --headless and --no-video)\n"
+              << "  --drop-frames       Drop output frames instead of waiting when the video encoder falls behind\n"
+              << "  --detection-scale N Find the cards at 1/N resolution (N = 1, 2 or 4) and refine their corners\n"
+              << "                      at full resolution\n"
+              << "  --contour-spacing PX Search the card corners on contours resampled every PX pixels of arc\n"
+              << "                      length instead of on every boundary pixel\n"
+              << "  --no-tracking       Classify every card on every keyframe instead of only the new or moved\n"
+              << "                      ones; the warps of cards that did not move are then served from a cache\n"
+              << "  --bit-packed-masks  Run the card mask morphology on one bit per pixel\n"
+              << "  --preprocess-bands N Build the card mask in N horizontal bands processed in parallel\n"
+              << "  --run-length-masks  Keep the card mask as runs of white pixels from the threshold to the contours\n"
+              << "  --rank-corners-only Warp and binarize only the rank corner of each card instead of the whole card\n";
+}
 
 int main(int argc, char **argv)
 {
-    std::string input_path = (argc > 1 ? argv[1] : "input_video.mp4");
+    std::string input_path = "input_video.mp4";
+    bool has_input_path = false;
+    bool headless = false;
+    bool write_video = true;
+    int offline_stride = 0;
+    bool drop_frames = false;
+    int detection_scale = 1;
+    double contour_spacing = 0.0;
+    bool track_cards = true;
+    bool bit_packed_masks = false;
+    int preprocess_bands = 1;
+    bool run_length_masks = false;
+    bool rank_corners_only = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool takes_value = arg == "--offline-stride" || arg == "--preprocess-bands" || arg == "--detection-scale" ||
+                           arg == "--contour-spacing";
+        if (takes_value && i + 1 >= argc)
+        {
+            std::cerr << "ERROR: Missing value for " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--no-video")
+            write_video = false;
+        else if (arg == "--drop-frames")
+            drop_frames = true;
+        else if (arg == "--no-tracking")
+            track_cards = false;
+        else if (arg == "--bit-packed-masks")
+            bit_packed_masks = true;
+        else if (arg == "--run-length-masks")
+            run_length_masks = true;
+        else if (arg == "--rank-corners-only")
+            rank_corners_only = true;
+        else if (arg == "--offline-stride")
+        {
+            offline_stride = std::atoi(argv[++i]);
+            if (offline_stride < 1)
+            {
+                std::cerr << "ERROR: --offline-stride expects a positive integer" << std::endl;
+                return 1;
+            }
+            // Skipped frames are never decoded, so there is nothing to show or write
+            headless = true;
+            write_video = false;
+        }
+        else if (arg == "--preprocess-bands")
+        {
+            preprocess_bands = std::atoi(argv[++i]);
+            if (preprocess_bands < 1)
+            {
+                std::cerr << "ERROR: --preprocess-bands expects a positive integer" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--detection-scale")
+        {
+            detection_scale = std::atoi(argv[++i]);
+            if (detection_scale != 1 && detection_scale != 2 && detection_scale != 4)
+            {
+                std::cerr << "ERROR: --detection-scale expects 1, 2 or 4" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--contour-spacing")
+        {
+            contour_spacing = std::atof(argv[++i]);
+            if (contour_spacing < 1.0)
+            {
+                std::cerr << "ERROR: --contour-spacing expects a spacing of at least 1 pixel" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--help" || arg == "-h")
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            std::cerr << "ERROR: Unknown option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            input_path = arg;
+            has_input_path = true;
+        }
+    }
+
     cv::VideoCapture cap(input_path);
 
     if (!cap.isOpened())
@@ -24,140 +155,61 @@ int main(int argc, char **argv)
     std::cout << "Opened " << input_path << " (" << width << "x" << height << " @ " << fps << " FPS)\n";
 
     cv::VideoWriter writer;
-    cv::Size frame_size(width, height);
-    bool is_color = true;
-
-    writer.open(
-        "output.mp4",
-        cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
-        fps,
-        frame_size,
-        is_color);
-
-    if (!writer.isOpened())
+    if (write_video)
     {
-        std::cerr << "Could not open the output video for write\n";
-        return -1;
-    }
-
-    cv::Mat frame, full_frame;
-    int frame_count = 0;
-    cv::Mat preprocessed_patch;
-    std::vector<std::vector<cv::Point>> rects, valid_rects;
-    std::vector<std::string> valid_texts;
+        cv::Size frame_size(width, height);
+        bool is_color = true;
 
-    static std::vector<std::vector<cv::Point>> last_valid_rects;
-    static std::vector<std::string> last_valid_texts;
+        writer.open(
+            "output.mp4",
+            cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+            fps,
+            frame_size,
+            is_color);
 
-    std::map<std::string, std::vector<std::pair<std::vector<cv::Point>, std::string>>> predictions;
-    cv::namedWindow("Original", cv::WINDOW_NORMAL);
-    // Main processing loop
-    while (true)
-    {
-        if (!cap.read(frame))
+        if (!writer.isOpened())
         {
-            std::cout << "End of video or cannot read frame\n";
-            break;
-        }
-
-        full_frame = frame.clone();
-
-        // Define Region of Interest (ROI)
-        int y = frame.rows / 2;
-        int x = frame.cols / 2;
-        int h = int(0.6 * y);
-        int w = int(0.8 * x);
-
-        cv::Rect roi_rect(x - w, y - h, 2 * w, 2 * h);
-        cv::Mat roi = frame(roi_rect);
-
-        if (frame_count % 2 == 0)
-        {
-            preprocessed_patch = roi.clone();
-            preprocessing_image(preprocessed_patch);
-            rects = process(preprocessed_patch);
-
-            cv::Mat mask = cv::Mat::zeros(roi.size(), CV_8U);
-            fillPoly(mask, rects, cv::Scalar(255));
-            cv::Mat result;
-            roi.copyTo(result, mask);
-            sharpen_image(result);
-            std::vector<cv::Mat> cards = get_cards(result, rects);
-
-            valid_rects.clear();
-            valid_texts.clear();
-
-            // Process each detected card
-            for (size_t i = 0; i < cards.size(); i++)
-            {
-                cv::Mat rank_patch = extract_rank_patch_center_based(cards[i]);
-
-                int total_pixels = rank_patch.rows * rank_patch.cols;
-                int black_pixels = total_pixels - cv::countNonZero(rank_patch);
-                double black_ratio = static_cast<double>(black_pixels) / total_pixels;
-
-                if (black_ratio > 0.4 || black_pixels < 500)
-                    continue;
-
-                std::string text = recognize_cards(rank_patch);
-
-                std::vector<cv::Point> translated;
-                for (const auto &pt : rects[i])
-                    translated.emplace_back(pt.x + roi_rect.x, pt.y + roi_rect.y);
-
-                valid_rects.push_back(translated);
-                valid_texts.push_back(text);
-            }
-
-            last_valid_rects = valid_rects;
-            last_valid_texts = valid_texts;
-        }
-
-        std::string current_frame_name = "frame_" + std::to_string(frame_count).insert(0, 6 - std::to_string(frame_count).length(), '0') + ".png";
-
-        for (size_t i = 0; i < last_valid_rects.size(); ++i)
-        {
-            predictions[current_frame_name].emplace_back(last_valid_rects[i], last_valid_texts[i]);
-
-            int hilo_value = get_hi_lo_value(last_valid_texts[i]);
-            cv::Scalar color = get_color_for_value(hilo_value);
-
-            cv::Mat overlay = full_frame.clone();
-            std::vector<std::vector<cv::Point>> poly{last_valid_rects[i]};
-            cv::fillPoly(overlay, poly, color);
-
-            double alpha = 0.3;
-            cv::addWeighted(overlay, alpha, full_frame, 1 - alpha, 0, full_frame);
-            cv::drawContours(full_frame, poly, -1, color, 1);
-
-            cv::Rect bbox = cv::boundingRect(last_valid_rects[i]);
-            cv::Point top_left = bbox.tl() + cv::Point(0, 0);
-            putText(full_frame, last_valid_texts[i], top_left, cv::FONT_HERSHEY_SIMPLEX, 0.7, color, 2);
-
-            cv::Point bottom_right = bbox.br() - cv::Point(-5, 10);
-            std::string hilo_str = (hilo_value > 0 ? "+" : "") + std::to_string(hilo_value);
-            putText(full_frame, hilo_str, bottom_right, cv::FONT_HERSHEY_SIMPLEX, 0.6, color, 2);
-        }
-
-        // Show result
-        cv::imshow("Computer Vision Homework 2", full_frame);
-        writer.write(full_frame);
-        char key = static_cast<char>(cv::waitKey(1));
-        if (key == 27)
-        {
-            std::cout << "Interrupted by user\n";
-            break;
+            std::cerr << "Could not open the output video for write\n";
+            return -1;
         }
+    }
 
-        frame_count++;
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    Predictions predictions;
+    PipelineConfig config;
+    config.show_window = !headless;
+    config.render_overlay = !headless || write_video;
+    config.interrupted = &interrupted;
+    config.detection_downscale = detection_scale;
+    config.contour_spacing = contour_spacing;
+    config.track_cards = track_cards;
+    config.bit_packed_masks = bit_packed_masks;
+    config.preprocess_bands = preprocess_bands;
+    config.run_length_masks = run_length_masks;
+    config.rank_corners_only = rank_corners_only;
+    if (drop_frames)
+        config.writer_policy = AsyncVideoWriter::OverflowPolicy::Drop;
+    if (offline_stride > 0)
+    {
+        config.detection_stride = offline_stride;
+        config.adaptive_stride = false;
+        config.decode_keyframes_only = true;
     }
 
-    if (argc <= 1)
+    // Decode, detect, classify, render and encode run concurrently on their own threads
+    PipelineStats stats = run_pipeline(cap, writer, config, predictions);
+    print_pipeline_stats(stats);
+
+    if (!has_input_path)
         evaluate_predictions("instances_default.json", predictions);
     writer.release();
     cap.release();
-    cv::destroyAllWindows();
+    if (!headless)
+        cv::destroyAllWindows();
 
-    std::cout << "Saved output.mp4\n";
+    if (write_video)
+        std::cout << "Saved output.mp4\n";
     return 0;
 }
@@ -21,33 +21,71 @@ torch::jit::script::Module load_card_model(const std::string &model_path)
     return model;
 }
 
-std::string recognize_cards(const cv::Mat &rank_patch)
+// Resizes a rank patch to the network input size and normalizes it to [-1, 1].
+static cv::Mat normalize_rank_patch(const cv::Mat &rank_patch)
 {
-    if (rank_patch.empty())
-        return "Invalid";
-
     cv::Mat resized;
     cv::resize(rank_patch, resized, cv::Size(128, 128));
     resized.convertTo(resized, CV_32F, 1.0 / 255);
     resized = (resized - 0.5f) / 0.5f;
+    return resized;
+}
+
+std::string recognize_cards(const cv::Mat &rank_patch)
+{
+    return recognize_cards_batch({rank_patch})[0];
+}
 
-    torch::Tensor input_tensor = torch::from_blob(resized.data, {1, 1, 128, 128}, torch::kFloat32).clone();
+std::vector<std::string> recognize_cards_batch(const std::vector<cv::Mat> &rank_patches)
+{
+    std::vector<std::string> labels(rank_patches.size(), "Invalid");
+
+    std::vector<size_t> batch_indices;
+    for (size_t i = 0; i < rank_patches.size(); ++i)
+    {
+        if (!rank_patches[i].empty())
+            batch_indices.push_back(i);
+    }
+    if (batch_indices.empty())
+        return labels;
+
+    // Stack every patch into a single NCHW tensor so the model is dispatched once
+    const int64_t batch_size = static_cast<int64_t>(batch_indices.size());
+    torch::Tensor input_tensor = torch::empty({batch_size, 1, 128, 128}, torch::kFloat32);
+    float *input_data = input_tensor.data_ptr<float>();
+    for (int64_t b = 0; b < batch_size; ++b)
+    {
+        cv::Mat slot(128, 128, CV_32F, input_data + b * 128 * 128);
+        normalize_rank_patch(rank_patches[batch_indices[b]]).copyTo(slot);
+    }
 
     torch::NoGradGuard no_grad;
     torch::Tensor output = card_model.forward({input_tensor}).toTensor();
+    torch::Tensor pred_indices = output.argmax(1).to(torch::kCPU);
+    auto preds = pred_indices.accessor<int64_t, 1>();
 
-    int pred_idx = output.argmax(1).item<int>();
-    if (pred_idx < 0 || pred_idx >= static_cast<int>(card_classes.size()))
-        return "Unknown";
+    for (int64_t b = 0; b < batch_size; ++b)
+    {
+        int64_t pred_idx = preds[b];
+        if (pred_idx < 0 || pred_idx >= static_cast<int64_t>(card_classes.size()))
+            labels[batch_indices[b]] = "Unknown";
+        else
+            labels[batch_indices[b]] = card_classes[pred_idx];
+    }
 
-    return card_classes[pred_idx];
+    return labels;
 }
 
-cv::Mat extract_rank_patch_center_based(const cv::Mat &gray)
+cv::Size rank_window_size()
 {
     const cv::Size baseWindow(70, 103);
     const double scale = 1.2;
-    cv::Size winSize(cvRound(baseWindow.width * scale), cvRound(baseWindow.height * scale));
+    return cv::Size(cvRound(baseWindow.width * scale), cvRound(baseWindow.height * scale));
+}
+
+cv::Mat extract_rank_patch_center_based(const cv::Mat &gray)
+{
+    cv::Size winSize = rank_window_size();
 
     if (gray.cols < winSize.width || gray.rows < winSize.height)
     {
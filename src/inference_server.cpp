@@ -0,0 +1,93 @@
+#include "inference_server.hpp"
+#include "detect.hpp"
+
+InferenceServer::InferenceServer(size_t max_batch_size, std::chrono::microseconds max_wait)
+    : max_batch_size_(max_batch_size > 0 ? max_batch_size : 1), max_wait_(max_wait)
+{
+    worker_ = std::thread(&InferenceServer::run, this);
+}
+
+InferenceServer::~InferenceServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+std::future<std::string> InferenceServer::submit(const cv::Mat &rank_patch)
+{
+    Request request;
+    request.patch = rank_patch;
+    request.enqueued = std::chrono::steady_clock::now();
+    std::future<std::string> label = request.label.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(request));
+    }
+    wake_.notify_one();
+    return label;
+}
+
+size_t InferenceServer::batches() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+}
+
+size_t InferenceServer::patches() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return patches_;
+}
+
+void InferenceServer::run()
+{
+    std::vector<Request> batch;
+    std::vector<cv::Mat> batch_patches;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]
+                       { return stopping_ || !pending_.empty(); });
+            if (pending_.empty())
+                return;
+
+            // Wait for the batch to fill up, but never past the deadline of the oldest patch
+            auto deadline = pending_.front().enqueued + max_wait_;
+            wake_.wait_until(lock, deadline, [this]
+                             { return stopping_ || pending_.size() >= max_batch_size_; });
+
+            size_t count = std::min(max_batch_size_, pending_.size());
+            batch.clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                batch.push_back(std::move(pending_.front()));
+                pending_.pop_front();
+            }
+            batches_++;
+            patches_ += count;
+        }
+
+        batch_patches.clear();
+        for (const auto &request : batch)
+            batch_patches.push_back(request.patch);
+
+        try
+        {
+            std::vector<std::string> labels = recognize_cards_batch(batch_patches);
+            for (size_t i = 0; i < batch.size(); ++i)
+                batch[i].label.set_value(labels[i]);
+        }
+        catch (...)
+        {
+            for (auto &request : batch)
+                request.label.set_exception(std::current_exception());
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#include "motion.hpp"
+
+void small_gray(const cv::Mat &roi, int downscale, cv::Mat &gray)
+{
+    cv::Size small_size(std::max(1, roi.cols / downscale), std::max(1, roi.rows / downscale));
+    cv::Mat small;
+    cv::resize(roi, small, small_size, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+}
+
+MotionDetector::MotionDetector(int downscale, int block_size, double block_threshold)
+    : downscale_(std::max(1, downscale)), block_size_(std::max(1, block_size)), block_threshold_(block_threshold)
+{
+}
+
+bool MotionDetector::changed(const cv::Mat &roi)
+{
+    small_gray(roi, downscale_, current_);
+
+    cv::Rect roi_bounds(0, 0, roi.cols, roi.rows);
+    if (reference_.empty() || reference_.size() != current_.size())
+    {
+        changed_region_ = roi_bounds;
+        return true;
+    }
+
+    cv::Mat diff;
+    cv::absdiff(current_, reference_, diff);
+
+    // Mean absolute difference of each block
+    cv::Size blocks((diff.cols + block_size_ - 1) / block_size_, (diff.rows + block_size_ - 1) / block_size_);
+    cv::Mat block_diff;
+    cv::resize(diff, block_diff, blocks, 0, 0, cv::INTER_AREA);
+
+    cv::Mat changed_blocks = block_diff > block_threshold_;
+    if (cv::countNonZero(changed_blocks) == 0)
+    {
+        changed_region_ = cv::Rect();
+        return false;
+    }
+
+    cv::Rect r = cv::boundingRect(changed_blocks);
+    double sx = static_cast<double>(roi.cols) / blocks.width;
+    double sy = static_cast<double>(roi.rows) / blocks.height;
+    int x0 = cvFloor(r.x * sx), y0 = cvFloor(r.y * sy);
+    int x1 = cvCeil((r.x + r.width) * sx), y1 = cvCeil((r.y + r.height) * sy);
+    changed_region_ = cv::Rect(x0, y0, x1 - x0, y1 - y0) & roi_bounds;
+    return true;
+}
+
+cv::Rect MotionDetector::changed_region() const
+{
+    return changed_region_;
+}
+
+void MotionDetector::set_keyframe()
+{
+    current_.copyTo(reference_);
+}
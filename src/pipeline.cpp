@@ -0,0 +1,610 @@
+#include "pipeline.hpp"
+#include "bounded_queue.hpp"
+#include "preprocess.hpp"
+#include "process.hpp"
+#include "detect.hpp"
+#include "render.hpp"
+#include "inference_server.hpp"
+#include "tracker.hpp"
+#include "warp_cache.hpp"
+#include "motion.hpp"
+#include "corner_propagator.hpp"
+#include "stride_controller.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <thread>
+
+using PacketQueue = BoundedQueue<FramePacket>;
+using Clock = std::chrono::steady_clock;
+
+static const std::string WINDOW_NAME = "Computer Vision Homework 2";
+
+static double elapsed_ms(const Clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::string frame_name(int frame_count)
+{
+    std::string number = std::to_string(frame_count);
+    if (number.length() < 6)
+        number.insert(0, 6 - number.length(), '0');
+    return "frame_" + number + ".png";
+}
+
+cv::Rect table_roi(const cv::Size &frame_size)
+{
+    int y = frame_size.height / 2;
+    int x = frame_size.width / 2;
+    int h = int(0.6 * y);
+    int w = int(0.8 * x);
+
+    return cv::Rect(x - w, y - h, 2 * w, 2 * h);
+}
+
+// Grows the changed region of the ROI until every card quad it touches lies entirely inside it,
+// so that no card mask is recomputed only in part.
+static cv::Rect search_region(cv::Rect region, const std::vector<std::vector<cv::Point>> &quads, const cv::Size &roi_size)
+{
+    cv::Rect bounds(0, 0, roi_size.width, roi_size.height);
+    bool grown = true;
+    while (grown)
+    {
+        grown = false;
+        for (const auto &quad : quads)
+        {
+            cv::Rect box = cv::boundingRect(quad) & bounds;
+            if ((box & region).area() > 0 && (box | region) != region)
+            {
+                region |= box;
+                grown = true;
+            }
+        }
+    }
+
+    // Updating most of the ROI piecewise is not worth the bookkeeping
+    if (region.area() > bounds.area() / 2)
+        region = bounds;
+    return region;
+}
+
+// Patch of the ROI to preprocess for recomputing the card mask inside `region`, downscaled to
+// the mask resolution, and where its result goes.
+struct MaskPatch
+{
+    cv::Mat image;
+    cv::Rect area;        // Mask pixels covered by the preprocessed patch.
+    cv::Rect mask_region; // Mask pixels to replace.
+    cv::Point offset;     // Position of mask_region in the preprocessed patch.
+};
+
+static MaskPatch prepare_mask_patch(const cv::Mat &roi, cv::Rect region, const cv::Size &mask_size, int f)
+{
+    // Wider than the combined reach of the 5x5 dilation and the 15x15 erosion
+    const int halo = 16;
+
+    // ROI area covered by the mask. Rectangles are aligned to whole mask pixels, so that a
+    // downscaled patch lines up with the pixels of the mask.
+    cv::Rect bounds(0, 0, mask_size.width * f, mask_size.height * f);
+    auto align = [f, &bounds](const cv::Rect &r)
+    {
+        int x0 = r.x / f * f, y0 = r.y / f * f;
+        int x1 = (r.x + r.width + f - 1) / f * f, y1 = (r.y + r.height + f - 1) / f * f;
+        return cv::Rect(x0, y0, x1 - x0, y1 - y0) & bounds;
+    };
+    region = align(region & bounds);
+    cv::Rect padded = align(cv::Rect(region.x - halo, region.y - halo, region.width + 2 * halo, region.height + 2 * halo) & bounds);
+
+    MaskPatch patch;
+    if (f > 1)
+        cv::resize(roi(padded), patch.image, padded.size() / f, 0, 0, cv::INTER_AREA);
+    else
+        patch.image = roi(padded).clone();
+    patch.area = cv::Rect(padded.tl() / f, padded.size() / f);
+    patch.mask_region = cv::Rect(region.tl() / f, region.size() / f);
+    patch.offset = (region.tl() - padded.tl()) / f;
+    return patch;
+}
+
+// Whether a shape of the preprocessed patch reaches one of its sides that lie inside the mask.
+// Such a shape may go on past the patch, so its holes were filled without seeing all of it.
+// `touches` tells whether the dilated patch, before hole filling, has set pixels along its left,
+// top, right and bottom side (see preprocessing_image).
+static bool cuts_shape(const MaskPatch &patch, const cv::Size &mask_size, const bool touches[4])
+{
+    return (touches[0] && patch.area.x > 0) || (touches[1] && patch.area.y > 0) ||
+           (touches[2] && patch.area.x + patch.area.width < mask_size.width) ||
+           (touches[3] && patch.area.y + patch.area.height < mask_size.height);
+}
+
+// Sides of the one-pixel ring around the patch in the mask, or none if the patch reaches the
+// border of the mask. When every pixel of the ring is set in the mask of the last keyframe, the
+// patch lies in a filled hole of a larger shape, and filling the holes of the patch alone would
+// leave its background cleared.
+static std::vector<cv::Rect> ring_sides(const MaskPatch &patch, const cv::Size &mask_size)
+{
+    const cv::Rect &a = patch.area;
+    if (a.x == 0 || a.y == 0 || a.x + a.width == mask_size.width || a.y + a.height == mask_size.height)
+        return {};
+    return {cv::Rect(a.x - 1, a.y - 1, a.width + 2, 1), cv::Rect(a.x - 1, a.y + a.height, a.width + 2, 1),
+            cv::Rect(a.x - 1, a.y, 1, a.height), cv::Rect(a.x + a.width, a.y, 1, a.height)};
+}
+
+// Recomputes the card mask inside `region` (in ROI coordinates) only and keeps the rest from the
+// last keyframe. The mask is `options.downscale` times smaller than the ROI on each side.
+// The whole mask is recomputed instead when a shape of the patch is cut by its border, or when
+// the patch lies in a filled hole (see ring_sides), so that the result is that of preprocessing
+// the whole ROI as long as the mask outside `region` has not changed since the last keyframe.
+static void update_card_mask(const cv::Mat &roi, cv::Rect region, cv::Mat &mask, const PreprocessOptions &options)
+{
+    MaskPatch patch = prepare_mask_patch(roi, region, mask.size(), options.downscale);
+    bool touches[4] = {false, false, false, false};
+    preprocessing_image(patch.image, options, touches);
+
+    std::vector<cv::Rect> ring = ring_sides(patch, mask.size());
+    bool enclosed = !ring.empty();
+    for (const cv::Rect &side : ring)
+        enclosed &= cv::countNonZero(mask(side)) == side.area();
+    if (cuts_shape(patch, mask.size(), touches) || enclosed)
+    {
+        update_card_mask(roi, cv::Rect(0, 0, roi.cols, roi.rows), mask, options);
+        return;
+    }
+    patch.image(cv::Rect(patch.offset, patch.mask_region.size())).copyTo(mask(patch.mask_region));
+}
+
+// Same as update_card_mask, for a mask kept as runs.
+static void update_card_runs(const cv::Mat &roi, cv::Rect region, RunMask &mask, const PreprocessOptions &options)
+{
+    MaskPatch patch = prepare_mask_patch(roi, region, mask.size(), options.downscale);
+    bool touches[4] = {false, false, false, false};
+    RunMask patch_mask = preprocessing_runs(patch.image, options, touches);
+
+    std::vector<cv::Rect> ring = ring_sides(patch, mask.size());
+    bool enclosed = !ring.empty();
+    for (const cv::Rect &side : ring)
+        enclosed &= mask.count(side) == static_cast<size_t>(side.area());
+    if (cuts_shape(patch, mask.size(), touches) || enclosed)
+    {
+        update_card_runs(roi, cv::Rect(0, 0, roi.cols, roi.rows), mask, options);
+        return;
+    }
+    mask.paste(patch.mask_region, patch_mask, patch.offset);
+}
+
+// Finds the cards in the ROI of a keyframe. The card mask is only recomputed inside `region`,
+// and the quads found in the whole mask are returned in `rects`. Only the cards whose track is
+// new or has moved are warped and have their rank patch submitted; the others keep the label
+// of their track.
+static void detect_cards(FramePacket &packet, cv::Rect region, cv::Mat &card_mask, RunMask &card_runs,
+                         std::vector<std::vector<cv::Point>> &rects, CardTracker &tracker, WarpCache &warp_cache, InferenceServer &server, const PipelineConfig &config,
+                         PipelineStats &stats)
+{
+    cv::Mat roi = packet.frame(packet.roi_rect);
+    const int downscale = std::max(1, config.detection_downscale);
+    cv::Size mask_size(roi.cols / downscale, roi.rows / downscale);
+    if ((config.run_length_masks ? card_runs.size() : card_mask.size()) != mask_size)
+    {
+        if (config.run_length_masks)
+            card_runs = RunMask(mask_size);
+        else
+            card_mask = cv::Mat::zeros(mask_size, CV_8U);
+        region = cv::Rect(0, 0, roi.cols, roi.rows);
+    }
+    PreprocessOptions preprocess_options;
+    preprocess_options.bit_packed = config.bit_packed_masks;
+    preprocess_options.bands = config.preprocess_bands;
+    preprocess_options.downscale = downscale;
+
+    ProcessParams params;
+    params.contour_spacing = config.contour_spacing;
+    ProcessParams scaled_params = scale_process_params(params, downscale);
+    if (config.run_length_masks)
+    {
+        update_card_runs(roi, region, card_runs, preprocess_options);
+        rects = process(card_runs, scaled_params);
+    }
+    else
+    {
+        update_card_mask(roi, region, card_mask, preprocess_options);
+        rects = process(card_mask, scaled_params);
+    }
+    if (downscale > 1)
+        rects = upscale_quads(roi, rects, downscale, params);
+    std::vector<CardTrack *> tracks = tracker.update(rects);
+
+    std::vector<CardTrack *> to_classify;
+    std::vector<std::vector<cv::Point>> to_classify_rects;
+    for (auto *track : tracks)
+    {
+        if (!tracker.needs_classification(*track))
+            continue;
+        to_classify.push_back(track);
+        to_classify_rects.push_back(track->quad);
+    }
+    stats.reused_labels += tracks.size() - to_classify.size();
+
+    if (!to_classify.empty())
+    {
+        cv::Mat mask = cv::Mat::zeros(roi.size(), CV_8U);
+        cv::fillPoly(mask, rects, cv::Scalar(255));
+        cv::Mat result;
+        roi.copyTo(result, mask);
+        sharpen_image(result);
+        // With tracking, only cards that moved past the tracker threshold get here, and their
+        // corners are too far from any cached quad for the tables to be reused
+        bool use_cache = config.cache_warps && !config.track_cards;
+        std::vector<cv::Mat> cards = config.rank_corners_only
+                                         ? get_rank_corners(result, to_classify_rects, rank_window_size())
+                                         : get_cards(result, to_classify_rects, use_cache ? &warp_cache : nullptr);
+
+        for (size_t i = 0; i < cards.size(); i++)
+        {
+            CardTrack &track = *to_classify[i];
+            cv::Mat rank_patch = extract_rank_patch_center_based(cards[i]);
+
+            int total_pixels = rank_patch.rows * rank_patch.cols;
+            int black_pixels = total_pixels - cv::countNonZero(rank_patch);
+            double black_ratio = static_cast<double>(black_pixels) / total_pixels;
+
+            track.classified_quad = track.quad;
+            track.rejected = black_ratio > 0.4 || black_pixels < 500;
+            track.label = track.rejected ? std::shared_future<std::string>() : server.submit(rank_patch).share();
+        }
+    }
+
+    for (const auto *track : tracks)
+    {
+        if (track->rejected || !track->label.valid())
+            continue;
+
+        std::vector<cv::Point> translated;
+        for (const auto &pt : track->quad)
+            translated.emplace_back(pt.x + packet.roi_rect.x, pt.y + packet.roi_rect.y);
+
+        packet.rects.push_back(translated);
+        packet.pending_texts.push_back(track->label);
+    }
+}
+
+static void decode_stage(cv::VideoCapture &cap, const PipelineConfig &config, StrideController &controller, PacketQueue &out,
+                         const std::atomic<bool> &stop, PipelineStats &stats)
+{
+    cv::Size frame_size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    for (int index = 0; !stop; ++index)
+    {
+        if (config.interrupted && *config.interrupted)
+        {
+            std::cout << "Interrupted by signal\n";
+            break;
+        }
+
+        auto start = Clock::now();
+        FramePacket packet;
+        packet.index = index;
+        packet.scheduled = controller.next_frame();
+        packet.keyframe = packet.scheduled;
+
+        // Frames that will not be looked at are only grabbed, skipping decoding and color conversion
+        bool read_ok = (packet.keyframe || !config.decode_keyframes_only) ? cap.read(packet.frame) : cap.grab();
+        if (!read_ok)
+        {
+            std::cout << "End of video or cannot read frame\n";
+            break;
+        }
+        if (!packet.frame.empty())
+            frame_size = packet.frame.size();
+        packet.roi_rect = table_roi(frame_size);
+        stats.decode_ms += elapsed_ms(start);
+
+        if (!out.push(std::move(packet)))
+            break;
+    }
+    out.close();
+}
+
+// Quads moved by `offset`, e.g. from ROI to frame coordinates.
+static std::vector<std::vector<cv::Point>> translate_quads(const std::vector<std::vector<cv::Point>> &quads, const cv::Point &offset)
+{
+    std::vector<std::vector<cv::Point>> translated = quads;
+    for (auto &quad : translated)
+        for (auto &pt : quad)
+            pt += offset;
+    return translated;
+}
+
+static void detect_stage(PacketQueue &in, PacketQueue &out, const PipelineConfig &config, InferenceServer &server, PipelineStats &stats)
+{
+    CardTracker tracker;
+    WarpCache warp_cache;
+    MotionDetector motion(4, 8, config.motion_threshold);
+    CornerPropagator propagator(2, cv::Size(15, 15), 3, 1.0, config.min_flow_confidence);
+    cv::Mat card_mask;
+    RunMask card_runs;
+    std::vector<std::vector<cv::Point>> last_rects;
+    std::vector<std::vector<cv::Point>> keyframe_rects; // Quads of the last keyframe, in frame coordinates.
+    std::vector<std::vector<cv::Point>> last_valid_rects;
+    std::vector<std::shared_future<std::string>> last_valid_texts;
+
+    FramePacket packet;
+    while (in.pop(packet))
+    {
+        auto start = Clock::now();
+        cv::Rect region(0, 0, packet.roi_rect.width, packet.roi_rect.height);
+
+        // The ROI is compared with the last keyframe at most once per frame
+        std::optional<bool> moved;
+        auto changed = [&]()
+        {
+            if (!moved)
+                moved = motion.changed(packet.frame(packet.roi_rect));
+            return *moved;
+        };
+        if (packet.keyframe && config.motion_gating)
+        {
+            if (changed())
+            {
+                region = search_region(motion.changed_region(), last_rects, region.size());
+                motion.set_keyframe();
+            }
+            else
+            {
+                packet.keyframe = false;
+                stats.motionless_keyframes++;
+            }
+        }
+
+        // Frames only grabbed have no pixels to track on, and keep the last quads
+        if (!packet.keyframe && config.propagate_corners && !packet.frame.empty())
+        {
+            std::vector<std::vector<cv::Point>> quads;
+            if (propagator.propagate(packet.frame(packet.roi_rect), quads))
+            {
+                last_valid_rects = translate_quads(quads, packet.roi_rect.tl());
+                stats.propagated_frames++;
+            }
+            else if (config.motion_gating && !changed())
+            {
+                // Nothing moved since the last keyframe, so its quads still hold: track them again
+                // from this frame instead of detecting
+                last_valid_rects = keyframe_rects;
+                propagator.reset(packet.frame(packet.roi_rect), translate_quads(keyframe_rects, -packet.roi_rect.tl()));
+                stats.reseeded_frames++;
+            }
+            else
+            {
+                // Tracking lost: detect on this frame rather than wait for the next keyframe
+                packet.keyframe = true;
+                stats.forced_keyframes++;
+                if (config.motion_gating)
+                {
+                    region = search_region(motion.changed_region(), last_rects, region.size());
+                    motion.set_keyframe();
+                }
+            }
+        }
+
+        if (packet.keyframe)
+        {
+            if (!config.track_cards)
+                tracker.clear();
+            detect_cards(packet, region, card_mask, card_runs, last_rects, tracker, warp_cache, server, config, stats);
+            warp_cache.next_frame();
+            stats.keyframes++;
+
+            keyframe_rects = packet.rects;
+            last_valid_rects = packet.rects;
+            last_valid_texts = packet.pending_texts;
+            if (config.propagate_corners)
+                propagator.reset(packet.frame(packet.roi_rect), translate_quads(packet.rects, -packet.roi_rect.tl()));
+        }
+        else
+        {
+            // Non-keyframes reuse the predictions of the last keyframe, moved along if propagated
+            packet.rects = last_valid_rects;
+            packet.pending_texts = last_valid_texts;
+        }
+        packet.detect_ms = elapsed_ms(start);
+        stats.detect_ms += packet.detect_ms;
+
+        if (!out.push(std::move(packet)))
+            break;
+    }
+    stats.cached_warps = warp_cache.hits();
+    out.close();
+}
+
+static void classify_stage(PacketQueue &in, PacketQueue &out, StrideController &controller, PipelineStats &stats)
+{
+    FramePacket packet;
+    while (in.pop(packet))
+    {
+        auto start = Clock::now();
+        packet.texts.clear();
+        for (const auto &label : packet.pending_texts)
+            packet.texts.push_back(label.get());
+        packet.pending_texts.clear();
+
+        double classify_ms = elapsed_ms(start);
+        stats.classify_ms += classify_ms;
+
+        // Keyframes skipped for lack of motion are reported too, so an idle table is checked often.
+        // Frames in between report the optical flow, or the detection run when tracking was lost.
+        if (packet.scheduled)
+            controller.record(packet.detect_ms + classify_ms);
+        else
+            controller.record_intermediate(packet.detect_ms + classify_ms);
+
+        if (!out.push(std::move(packet)))
+            break;
+    }
+    out.close();
+}
+
+static void render_stage(PacketQueue &in, PacketQueue &out, const PipelineConfig &config, Predictions &predictions, PipelineStats &stats)
+{
+    FramePacket packet;
+    while (in.pop(packet))
+    {
+        auto start = Clock::now();
+        std::string current_frame_name = frame_name(packet.index);
+        for (size_t i = 0; i < packet.rects.size(); ++i)
+            predictions[current_frame_name].emplace_back(packet.rects[i], packet.texts[i]);
+
+        if (config.render_overlay && !packet.frame.empty())
+            draw_card_overlays(packet.frame, packet.rects, packet.texts);
+        stats.render_ms += elapsed_ms(start);
+
+        if (!out.push(std::move(packet)))
+            break;
+    }
+    out.close();
+}
+
+static void encode_stage(PacketQueue &in, AsyncVideoWriter *writer, PacketQueue *display, PipelineStats &stats)
+{
+    // Packets are written strictly by frame index, holding back any that arrive early
+    std::map<int, FramePacket> pending;
+    int next_index = 0;
+
+    FramePacket packet;
+    while (in.pop(packet))
+    {
+        int index = packet.index;
+        pending.emplace(index, std::move(packet));
+
+        while (!pending.empty() && pending.begin()->first == next_index)
+        {
+            FramePacket &ready = pending.begin()->second;
+            if (writer && !ready.frame.empty())
+                writer->write(ready.frame);
+            stats.frames++;
+
+            if (display)
+                display->push(std::move(ready));
+            pending.erase(pending.begin());
+            next_index++;
+        }
+    }
+    if (display)
+        display->close();
+}
+
+PipelineStats run_pipeline(cv::VideoCapture &cap, cv::VideoWriter &writer, const PipelineConfig &config, Predictions &predictions)
+{
+    PipelineStats stats;
+    InferenceServer server(config.max_batch_size, std::chrono::microseconds(config.max_batch_wait_us));
+    StrideController controller(config.target_latency_ms, config.max_stride, config.detection_stride, config.adaptive_stride);
+    PacketQueue decoded(config.queue_capacity);
+    PacketQueue detected(config.queue_capacity);
+    PacketQueue classified(config.queue_capacity);
+    PacketQueue rendered(config.queue_capacity);
+    PacketQueue displayed(config.queue_capacity);
+    std::atomic<bool> stop(false);
+
+    std::unique_ptr<AsyncVideoWriter> async_writer;
+    if (writer.isOpened())
+    {
+        cv::Size frame_size(static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+        async_writer = std::make_unique<AsyncVideoWriter>(writer, frame_size, CV_8UC3, config.writer_capacity, config.writer_policy);
+    }
+
+    auto stop_pipeline = [&]()
+    {
+        stop = true;
+        decoded.close();
+        detected.close();
+        classified.close();
+        rendered.close();
+        displayed.close();
+    };
+
+    auto start = Clock::now();
+    std::thread decoder([&]
+                        { decode_stage(cap, config, controller, decoded, stop, stats); });
+    std::thread detector([&]
+                         { detect_stage(decoded, detected, config, server, stats); });
+    std::thread classifier([&]
+                           { classify_stage(detected, classified, controller, stats); });
+    std::thread renderer([&]
+                         { render_stage(classified, rendered, config, predictions, stats); });
+    std::thread encoder([&]
+                        { encode_stage(rendered, async_writer.get(), config.show_window ? &displayed : nullptr, stats); });
+
+    // HighGUI must be driven from the main thread
+    if (config.show_window)
+    {
+        cv::namedWindow(WINDOW_NAME, cv::WINDOW_NORMAL);
+        FramePacket packet;
+        while (displayed.pop(packet))
+        {
+            if (packet.frame.empty())
+                continue;
+            cv::imshow(WINDOW_NAME, packet.frame);
+            char key = static_cast<char>(cv::waitKey(1));
+            if (key == 27)
+            {
+                std::cout << "Interrupted by user\n";
+                stop_pipeline();
+                break;
+            }
+        }
+    }
+
+    decoder.join();
+    detector.join();
+    classifier.join();
+    renderer.join();
+    encoder.join();
+    if (async_writer)
+    {
+        async_writer->close();
+        stats.encode_ms = async_writer->encode_ms();
+        stats.dropped_frames = async_writer->dropped();
+    }
+
+    stats.wall_ms = elapsed_ms(start);
+    stats.inference_batches = server.batches();
+    stats.inference_patches = server.patches();
+    stats.stride = controller.stride();
+    stats.keyframe_latency_ms = controller.keyframe_latency_ms();
+    stats.intermediate_latency_ms = controller.intermediate_latency_ms();
+    stats.frame_latency_ms = controller.frame_latency_ms();
+    return stats;
+}
+
+void print_pipeline_stats(const PipelineStats &stats)
+{
+    if (stats.frames == 0)
+        return;
+
+    double n = static_cast<double>(stats.frames);
+    std::cout << "Processed " << stats.frames << " frames (" << stats.keyframes << " keyframes, "
+              << stats.motionless_keyframes << " skipped without motion) in "
+              << stats.wall_ms / 1000.0 << " s (" << n * 1000.0 / stats.wall_ms << " FPS)\n";
+    std::cout << "Average stage time per frame [ms]:"
+              << " decode " << stats.decode_ms / n
+              << ", detect " << stats.detect_ms / n
+              << ", classify " << stats.classify_ms / n
+              << ", render " << stats.render_ms / n
+              << ", encode " << stats.encode_ms / n << "\n";
+    if (stats.dropped_frames > 0)
+        std::cout << "Dropped " << stats.dropped_frames << " frames because the video encoder fell behind\n";
+    std::cout << "Detection stride " << stats.stride << ": " << stats.keyframe_latency_ms << " ms per keyframe, "
+              << stats.intermediate_latency_ms << " ms per frame in between, " << stats.frame_latency_ms << " ms per frame\n";
+    if (stats.inference_batches > 0)
+        std::cout << "Classified " << stats.inference_patches << " rank patches in " << stats.inference_batches
+                  << " batches (" << static_cast<double>(stats.inference_patches) / stats.inference_batches
+                  << " patches per batch)\n";
+    if (stats.reused_labels > 0)
+        std::cout << "Reused the label of " << stats.reused_labels << " tracked cards without classifying them\n";
+    if (stats.cached_warps > 0)
+        std::cout << "Warped " << stats.cached_warps << " cards with cached remap tables\n";
+    if (stats.propagated_frames > 0 || stats.forced_keyframes > 0 || stats.reseeded_frames > 0)
+        std::cout << "Moved the quads of " << stats.propagated_frames << " frames with optical flow, detected on "
+                  << stats.forced_keyframes << " extra frames where tracking was lost, and restarted tracking without motion on "
+                  << stats.reseeded_frames << " frames\n";
+}
@@ -1,6 +1,8 @@
 // Francesco Pivotto 2158296
 
 #include "preprocess.hpp"
+#include "bit_mask.hpp"
+#include "simd_config.hpp"
 
 void preprocessing_card(cv::Mat &image)
 {
@@ -10,8 +12,14 @@ void preprocessing_card(cv::Mat &image)
         return;
     }
 
+    enhance_card(image);
+    cv::threshold(image, image, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+}
+
+void enhance_card(cv::Mat &image, const cv::Size &tiles, const cv::Size &blur_size)
+{
     cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
-    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(8, 8));
+    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, tiles);
     clahe->apply(image, image);
 
     // Sharpening
@@ -19,11 +27,163 @@ void preprocessing_card(cv::Mat &image)
                       -1, 5, -1,
                       0, -1, 0);
     cv::filter2D(image, image, -1, kernel);
-    cv::GaussianBlur(image, image, cv::Size(9, 9), 0);
-    cv::threshold(image, image, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    cv::GaussianBlur(image, image, blur_size, 0);
+}
+
+// Largest max - min channel spread whose 8-bit HSV saturation is at most 40, for V = max >= 245.
+// OpenCV computes S = (spread * round((255 << 12) / V) + (1 << 11)) >> 12, which gives 38 for
+// V = 245, 39 for V in [246, 251] and 40 for V in [252, 255].
+static inline int max_white_spread(int v)
+{
+    return 38 + (v >= 246) + (v >= 252);
+}
+
+void white_mask(const cv::Mat &image, cv::Mat &mask)
+{
+    CV_Assert(image.type() == CV_8UC3);
+    mask.create(image.size(), CV_8U);
+
+    for (int y = 0; y < image.rows; y++)
+    {
+        const uchar *src = image.ptr<uchar>(y);
+        uchar *dst = mask.ptr<uchar>(y);
+        int x = 0;
+#if HAS_INTRINSIC_FUNCTIONS && (CV_SIMD || CV_SIMD_SCALABLE)
+        const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+        const cv::v_uint8 min_value = cv::vx_setall_u8(245);
+        const cv::v_uint8 first_step = cv::vx_setall_u8(246);
+        const cv::v_uint8 second_step = cv::vx_setall_u8(252);
+        const cv::v_uint8 base_spread = cv::vx_setall_u8(38);
+        const cv::v_uint8 one = cv::vx_setall_u8(1);
+        for (; x <= image.cols - lanes; x += lanes)
+        {
+            cv::v_uint8 b, g, r;
+            cv::v_load_deinterleave(src + 3 * x, b, g, r);
+            cv::v_uint8 v = cv::v_max(cv::v_max(b, g), r);
+            cv::v_uint8 spread = cv::v_sub(v, cv::v_min(cv::v_min(b, g), r));
+            cv::v_uint8 limit = cv::v_add(cv::v_add(base_spread, cv::v_and(cv::v_ge(v, first_step), one)),
+                                          cv::v_and(cv::v_ge(v, second_step), one));
+            cv::v_store(dst + x, cv::v_and(cv::v_ge(v, min_value), cv::v_le(spread, limit)));
+        }
+#endif
+        for (; x < image.cols; x++)
+        {
+            int b = src[3 * x], g = src[3 * x + 1], r = src[3 * x + 2];
+            int v = std::max(std::max(b, g), r);
+            int spread = v - std::min(std::min(b, g), r);
+            dst[x] = (v >= 245 && spread <= max_white_spread(v)) ? 255 : 0;
+        }
+    }
+}
+
+RunMask white_mask_runs(const cv::Mat &image)
+{
+    CV_Assert(image.type() == CV_8UC3);
+    RunMask runs(cv::Size(image.cols, 0));
+    cv::Mat row_mask;
+    for (int y = 0; y < image.rows; y++)
+    {
+        white_mask(image.row(y), row_mask);
+        runs.push_row(row_mask.ptr<uchar>(0));
+    }
+    return runs;
+}
+
+void fill_holes(cv::Mat &mask)
+{
+    CV_Assert(mask.type() == CV_8U);
+
+    // A one-pixel frame lets a single seed reach all the background touching the image border
+    cv::Mat outside = cv::Mat::zeros(mask.rows + 2, mask.cols + 2, CV_8U);
+    cv::Rect inner(1, 1, mask.cols, mask.rows);
+    mask.copyTo(outside(inner));
+
+    // Background is 4-connected, the complement of the 8-connected shapes traced by findContours
+    const uchar reached = 128;
+    cv::floodFill(outside, cv::Point(0, 0), cv::Scalar(reached), nullptr, cv::Scalar(), cv::Scalar(), 4);
+    cv::compare(outside(inner), cv::Scalar(reached), mask, cv::CMP_NE);
+}
+
+// Rows [y0, y1) of the morphology of `src`, computed from those rows plus a halo of
+// neighbouring rows as wide as the kernel reaches, and written to the same rows of `dst`.
+static void morphology_band(const cv::Mat &src, cv::Mat &dst, int op, const cv::Mat &kernel, int y0, int y1)
+{
+    int halo_top = kernel.rows / 2, halo_bottom = kernel.rows - 1 - halo_top;
+    int top = std::max(0, y0 - halo_top), bottom = std::min(src.rows, y1 + halo_bottom);
+
+    // Isolated: the rows past the halo must look like the image border, as in the serial path
+    cv::Mat band;
+    cv::morphologyEx(src.rowRange(top, bottom), band, op, kernel, cv::Point(-1, -1), 1,
+                     cv::BORDER_CONSTANT | cv::BORDER_ISOLATED, cv::morphologyDefaultBorderValue());
+    band.rowRange(y0 - top, y1 - top).copyTo(dst.rowRange(y0, y1));
+}
+
+// Side of a square kernel of `size` pixels at full resolution, for an image downscaled by `downscale`.
+static cv::Size scaled_kernel(int size, int downscale)
+{
+    int radius = static_cast<int>(std::lround((size / 2) / static_cast<double>(std::max(1, downscale))));
+    return cv::Size(2 * radius + 1, 2 * radius + 1);
 }
 
-void preprocessing_image(cv::Mat &image)
+// Sets the 4 values of `touches`, if not null, to whether `count` finds set pixels in the strips
+// of the dilation radius + 1 pixels along the left, top, right and bottom side of a `size` mask.
+template <typename Count>
+static void find_touched_sides(const cv::Size &size, const cv::Size &dilate_size, Count count, bool *touches)
+{
+    if (!touches)
+        return;
+    int w = std::min(dilate_size.width / 2 + 1, size.width), h = std::min(dilate_size.height / 2 + 1, size.height);
+    const cv::Rect strips[4] = {cv::Rect(0, 0, w, size.height), cv::Rect(0, 0, size.width, h),
+                                cv::Rect(size.width - w, 0, w, size.height), cv::Rect(0, size.height - h, size.width, h)};
+    for (int i = 0; i < 4; i++)
+        touches[i] = count(strips[i]) > 0;
+}
+
+static void preprocessing_image_banded(cv::Mat &image, int bands, const cv::Size &dilate_size, const cv::Size &erode_size, bool *touches)
+{
+    bands = std::min(bands, image.rows);
+    auto band_rows = [&](int band)
+    {
+        return cv::Range(band * image.rows / bands, (band + 1) * image.rows / bands);
+    };
+
+    cv::Mat mask(image.size(), CV_8U), dilated(image.size(), CV_8U);
+    cv::Mat dilate_kernel = cv::getStructuringElement(cv::MORPH_RECT, dilate_size);
+    cv::Mat erode_kernel = cv::getStructuringElement(cv::MORPH_RECT, erode_size);
+
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                      {
+                          for (int band = range.start; band < range.end; band++)
+                          {
+                              cv::Range rows = band_rows(band);
+                              cv::Mat band_mask = mask.rowRange(rows);
+                              white_mask(image.rowRange(rows), band_mask);
+                          } });
+
+    // The dilation of a band reads the white mask of its neighbours, so it waits for all of them
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                      {
+                          for (int band = range.start; band < range.end; band++)
+                          {
+                              cv::Range rows = band_rows(band);
+                              morphology_band(mask, dilated, cv::MORPH_DILATE, dilate_kernel, rows.start, rows.end);
+                          } });
+
+    find_touched_sides(dilated.size(), dilate_size, [&dilated](const cv::Rect &r)
+                       { return cv::countNonZero(dilated(r)); }, touches);
+    fill_holes(dilated);
+
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range &range)
+                      {
+                          for (int band = range.start; band < range.end; band++)
+                          {
+                              cv::Range rows = band_rows(band);
+                              morphology_band(dilated, mask, cv::MORPH_ERODE, erode_kernel, rows.start, rows.end);
+                          } });
+    image = mask;
+}
+
+void preprocessing_image(cv::Mat &image, const PreprocessOptions &options, bool *touches)
 {
     if (image.empty())
     {
@@ -31,24 +191,55 @@ void preprocessing_image(cv::Mat &image)
         return;
     }
 
-    cv::Mat hsv;
-    cv::cvtColor(image, hsv, cv::COLOR_BGR2HSV);
+    if (options.run_length)
+    {
+        preprocessing_runs(image, options, touches).to_mat(image);
+        return;
+    }
+
+    cv::Size dilate_size = scaled_kernel(5, options.downscale);
+    cv::Size erode_size = scaled_kernel(15, options.downscale);
+
+    if (options.bands > 1 && !options.bit_packed)
+    {
+        preprocessing_image_banded(image, options.bands, dilate_size, erode_size, touches);
+        return;
+    }
+
+    // Only which pixels are nonzero matters from here on: the dilation, hole filling and
+    // erosion give the same result on the binary mask as on the masked gray image
     cv::Mat mask_white;
-    cv::inRange(hsv,
-                cv::Scalar(0, 0, 245),
-                cv::Scalar(180, 40, 255),
-                mask_white);
-    cv::Mat white_like = cv::Mat::zeros(image.size(), image.type());
-    image.setTo(cv::Scalar(0, 0, 0), ~mask_white);
-    cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
+    white_mask(image, mask_white);
+    image = mask_white;
+
+    if (options.bit_packed)
+    {
+        BitMask mask = BitMask::from_mat(image).dilate(dilate_size);
+        find_touched_sides(mask.size(), dilate_size, [&mask](const cv::Rect &r)
+                           { return mask.count(r); }, touches);
+        mask.fill_holes();
+        mask.erode(erode_size).to_mat(image);
+        return;
+    }
+
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, dilate_size);
     cv::dilate(image, image, kernel);
 
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(image, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
-    cv::fillPoly(image, contours, cv::Scalar(255));
+    find_touched_sides(image.size(), dilate_size, [&image](const cv::Rect &r)
+                       { return cv::countNonZero(image(r)); }, touches);
+    fill_holes(image);
 
     // Erode the result to smooth and shrink the shapes slightly
-    kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(15, 15));
+    kernel = cv::getStructuringElement(cv::MORPH_RECT, erode_size);
     cv::erode(image, image, kernel);
 }
+
+RunMask preprocessing_runs(const cv::Mat &image, const PreprocessOptions &options, bool *touches)
+{
+    cv::Size dilate_size = scaled_kernel(5, options.downscale);
+    RunMask mask = white_mask_runs(image).dilate(dilate_size);
+    find_touched_sides(mask.size(), dilate_size, [&mask](const cv::Rect &r)
+                       { return mask.count(r); }, touches);
+    mask.fill_holes();
+    return mask.erode(scaled_kernel(15, options.downscale));
+}
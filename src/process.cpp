@@ -1,7 +1,36 @@
 // Francesco Pivotto 2158296
 
 #include "process.hpp"
+#include "contour_geometry.hpp"
 #include "preprocess.hpp"
+#include "rle_mask.hpp"
+#include "warp_cache.hpp"
+
+#include <deque>
+#include <functional>
+
+// Outward direction of the bottom-left, bottom-right, top-right and top-left corners of a quad
+static const cv::Point CORNER_OUTWARD[4] = {cv::Point(-1, 1), cv::Point(1, 1), cv::Point(1, -1), cv::Point(-1, -1)};
+
+// Corner k of a quad found by extract_points_from_pairs, without the padding it was pushed out by
+static cv::Point unpadded_corner(const std::vector<cv::Point> &quad, int k, int tolerance)
+{
+    return quad[k] - CORNER_OUTWARD[k] * tolerance;
+}
+
+ProcessParams scale_process_params(const ProcessParams &params, int downscale)
+{
+    ProcessParams scaled = params;
+    double s = 1.0 / std::max(1, downscale);
+    scaled.min_area = params.min_area * s * s;
+    scaled.min_perimeter = params.min_perimeter * s;
+    scaled.pixel_tolerance = std::max(1, cvRound(params.pixel_tolerance * s));
+    scaled.peak_window = std::max(1, cvRound(params.peak_window * s));
+    scaled.min_prominence = params.min_prominence * s;
+    if (params.contour_spacing > 0)
+        scaled.contour_spacing = std::max(1.0, params.contour_spacing * s);
+    return scaled;
+}
 
 std::vector<std::vector<cv::Point>> filter_contours(const std::vector<std::vector<cv::Point>> &contours, double min_area, double min_perimeter)
 {
@@ -22,27 +51,18 @@ std::vector<cv::Point> find_closest_to_corners(const std::vector<cv::Point> &car
 {
     cv::Point tr_corner(img_size.width - 1, 0);
     cv::Point bl_corner(0, img_size.height - 1);
-    cv::Point tr_closest(-1, -1), bl_closest(-1, -1);
-
-    double tr_minDist = std::numeric_limits<double>::max();
-    double bl_minDist = std::numeric_limits<double>::max();
+    if (card.empty())
+        return {cv::Point(-1, -1), cv::Point(-1, -1)};
 
-    for (const auto &pt : card)
-    {
-        double tr_dist = cv::norm(pt - tr_corner);
-        if (tr_dist < tr_minDist)
-        {
-            tr_minDist = tr_dist;
-            tr_closest = pt;
-        }
+    // Squared distances order the points as the distances do, ties going to the first point
+    ContourCoords coords;
+    std::vector<int> distances;
+    split_contour(card, coords);
 
-        double bl_dist = cv::norm(pt - bl_corner);
-        if (bl_dist < bl_minDist)
-        {
-            bl_minDist = bl_dist;
-            bl_closest = pt;
-        }
-    }
+    squared_distances(coords, bl_corner, distances);
+    cv::Point bl_closest = card[argmin(distances)];
+    squared_distances(coords, tr_corner, distances);
+    cv::Point tr_closest = card[argmin(distances)];
 
     return {bl_closest, tr_closest};
 }
@@ -61,28 +81,54 @@ double point_line_distance(const cv::Point &p, const cv::Point &p1, const cv::Po
     return std::abs(d1.x * d2.y - d1.y * d2.x) / line_length;
 }
 
+// Extreme value of every window of `width` consecutive elements: element j covers [j, j + width).
+// Each index enters and leaves the monotonic deque once, so the cost is O(n) whatever the width.
+template <typename Compare>
+static std::vector<double> sliding_extreme(const std::vector<double> &values, int width, Compare better)
+{
+    int n = static_cast<int>(values.size());
+    std::vector<double> extremes;
+    if (width < 1 || n < width)
+        return extremes;
+    extremes.reserve(n - width + 1);
+
+    // Indices whose values are strictly monotonic from front to back; the front is the extreme
+    std::deque<int> candidates;
+    for (int i = 0; i < n; ++i)
+    {
+        while (!candidates.empty() && !better(values[candidates.back()], values[i]))
+            candidates.pop_back();
+        candidates.push_back(i);
+        if (candidates.front() <= i - width)
+            candidates.pop_front();
+        if (i >= width - 1)
+            extremes.push_back(values[candidates.front()]);
+    }
+    return extremes;
+}
+
 std::vector<int> find_local_maxima(const std::vector<double> &distances, int window_size, double min_prominence)
 {
     std::vector<int> local_maxima;
     int n = static_cast<int>(distances.size());
+    if (window_size < 1 || n < 2 * window_size + 1)
+        return local_maxima;
+
+    // window_max[i - window_size] is the maximum over [i - window_size, i + window_size], and
+    // side_min[j] the minimum over the window_size elements starting at j
+    std::vector<double> window_max = sliding_extreme(distances, 2 * window_size + 1, std::greater<double>());
+    std::vector<double> side_min = sliding_extreme(distances, window_size, std::less<double>());
 
     for (int i = window_size; i < n - window_size; ++i)
     {
         double current = distances[i];
-        bool is_peak = true;
-        for (int j = i - window_size; j <= i + window_size; ++j)
-        {
-            if (distances[j] > current)
-            {
-                is_peak = false;
-                break;
-            }
-        }
+        // No neighbour is larger
+        bool is_peak = window_max[i - window_size] <= current;
 
         if (is_peak)
         {
-            double left = *std::min_element(distances.begin() + i - window_size, distances.begin() + i);
-            double right = *std::min_element(distances.begin() + i + 1, distances.begin() + i + window_size + 1);
+            double left = side_min[i - window_size];
+            double right = side_min[i + 1];
             double prominence = current - std::max(left, right);
 
             if (prominence >= min_prominence)
@@ -111,7 +157,8 @@ std::vector<std::pair<int, int>> pair_indices_symmetric(const std::vector<int> &
     return pairs;
 }
 
-std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<std::vector<cv::Point>> &cards, const std::vector<std::vector<cv::Point>> &ext_pts)
+std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<std::vector<cv::Point>> &cards, const std::vector<std::vector<cv::Point>> &ext_pts,
+                                                              const ProcessParams &params)
 {
     std::vector<std::vector<cv::Point>> corner_pts;
     cv::Point bl, br, tr, tl;
@@ -120,9 +167,13 @@ std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<
     std::vector<int> max_indices;
     int i = 0, j = 0;
 
-    const int PIXEL_TOLERANCE = 7;
+    const int PIXEL_TOLERANCE = params.pixel_tolerance;
+    // Resampled contours have one point every contour_spacing pixels of arc length
+    const int PEAK_WINDOW = params.contour_spacing > 0 ? std::max(1, cvRound(params.peak_window / params.contour_spacing))
+                                                       : params.peak_window;
 
     std::vector<double> distances;
+    ContourCoords coords;
     double line_length;
 
     for (auto &card : cards)
@@ -133,12 +184,11 @@ std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<
 
         i++;
         line_length = cv::norm(tr - bl);
-        distances.clear();
-        distances.reserve(card.size());
-
-        for (const auto &pt : card)
-            distances.push_back(point_line_distance(pt, bl, tr, line_length));
-        max_indices = find_local_maxima(distances, 25);
+        split_contour(card, coords);
+        signed_line_distances(coords, bl, tr, line_length, distances);
+        for (double &d : distances)
+            d = std::abs(d);
+        max_indices = find_local_maxima(distances, PEAK_WINDOW, params.min_prominence);
 
         paired_indices = pair_indices_symmetric(max_indices);
 
@@ -178,24 +228,201 @@ std::vector<std::vector<cv::Point>> extract_points_from_pairs(const std::vector<
     return corner_pts;
 }
 
-std::vector<std::vector<cv::Point>> process(cv::Mat &image)
+MaskComponents label_components(const cv::Mat &mask)
+{
+    MaskComponents components;
+    cv::Mat centroids;
+    components.count = cv::connectedComponentsWithStats(mask, components.labels, components.stats, centroids, 8, CV_32S);
+    return components;
+}
+
+// Whether the contour of a component with this bounding box and pixel count can enclose min_area:
+// both are upper bounds of the area of the polygon through the centres of its boundary pixels
+static bool may_enclose(const cv::Rect &box, int area, double min_area)
+{
+    return area >= min_area && static_cast<double>(box.width - 1) * (box.height - 1) >= min_area;
+}
+
+// Same order as findContours over the whole mask: last starting point in raster order first
+static void sort_as_find_contours(std::vector<std::vector<cv::Point>> &contours)
+{
+    std::sort(contours.begin(), contours.end(), [](const std::vector<cv::Point> &a, const std::vector<cv::Point> &b)
+              {
+                  if (a.front().y != b.front().y)
+                      return a.front().y > b.front().y;
+                  return a.front().x > b.front().x; });
+}
+
+std::vector<BlobCandidate> select_candidates(const MaskComponents &components, double min_area)
+{
+    std::vector<BlobCandidate> candidates;
+    for (int label = 1; label < components.count; label++)
+    {
+        const int *row = components.stats.ptr<int>(label);
+        BlobCandidate blob;
+        blob.label = label;
+        blob.box = cv::Rect(row[cv::CC_STAT_LEFT], row[cv::CC_STAT_TOP], row[cv::CC_STAT_WIDTH], row[cv::CC_STAT_HEIGHT]);
+        blob.area = row[cv::CC_STAT_AREA];
+        if (may_enclose(blob.box, blob.area, min_area))
+            candidates.push_back(blob);
+    }
+    return candidates;
+}
+
+std::vector<std::vector<cv::Point>> trace_components(const MaskComponents &components, const std::vector<BlobCandidate> &candidates,
+                                                     int approximation)
+{
+    std::vector<std::vector<cv::Point>> contours;
+    cv::Rect bounds(0, 0, components.labels.cols, components.labels.rows);
+    for (const auto &blob : candidates)
+    {
+        cv::Rect padded = cv::Rect(blob.box.x - 1, blob.box.y - 1, blob.box.width + 2, blob.box.height + 2) & bounds;
+        cv::Mat component = components.labels(padded) == blob.label;
+
+        std::vector<std::vector<cv::Point>> traced;
+        cv::findContours(component, traced, cv::RETR_EXTERNAL, approximation, padded.tl());
+        if (!traced.empty())
+            contours.push_back(std::move(traced.front()));
+    }
+
+    sort_as_find_contours(contours);
+    return contours;
+}
+
+std::vector<cv::Point> resample_contour(const std::vector<cv::Point> &contour, double spacing)
+{
+    if (contour.size() < 2 || spacing <= 0)
+        return contour;
+
+    std::vector<cv::Point> resampled;
+    // Arc length from the start of the current edge to the next sample
+    double offset = 0.0;
+    for (size_t i = 0; i < contour.size(); i++)
+    {
+        cv::Point2d a = contour[i];
+        cv::Point2d b = contour[(i + 1) % contour.size()];
+        double length = cv::norm(b - a);
+        for (; offset < length; offset += spacing)
+        {
+            cv::Point2d p = a + (b - a) * (offset / length);
+            resampled.emplace_back(cvRound(p.x), cvRound(p.y));
+        }
+        offset -= length;
+    }
+    return resampled;
+}
+
+// Steps of process() after tracing: filters, corner search and quad extraction
+static std::vector<std::vector<cv::Point>> find_card_quads(const std::vector<std::vector<cv::Point>> &contours, const cv::Size &size,
+                                                           const ProcessParams &params)
+{
+    std::vector<std::vector<cv::Point>> cards = filter_contours(contours, params.min_area, params.min_perimeter);
+    if (params.contour_spacing > 0)
+    {
+        for (auto &card : cards)
+            card = resample_contour(card, params.contour_spacing);
+    }
+
+    std::vector<std::vector<cv::Point>> ext_pts;
+    for (auto &card : cards)
+    {
+        auto corners = find_closest_to_corners(card, size);
+        ext_pts.push_back(corners);
+        reorder_contour_with_bottom_left_first(card, corners[0]);
+    }
+    return extract_points_from_pairs(cards, ext_pts, params);
+}
+
+std::vector<std::vector<cv::Point>> process(cv::Mat &image, const ProcessParams &params)
 {
-    std::vector<std::vector<cv::Point>> contours, cards, ext_points, lines;
     if (image.empty())
     {
         std::cout << "Image is empty" << std::endl;
         return {};
     }
-    cv::findContours(image.clone(), contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
-    cards = filter_contours(contours, 3000, 250);
+    // Dropping the inner points of straight runs changes neither the area nor the perimeter
+    int approximation = params.contour_spacing > 0 ? cv::CHAIN_APPROX_SIMPLE : cv::CHAIN_APPROX_NONE;
+    MaskComponents components = label_components(image);
+    std::vector<std::vector<cv::Point>> contours = trace_components(components, select_candidates(components, params.min_area), approximation);
+    return find_card_quads(contours, image.size(), params);
+}
 
-    for (auto &card : cards)
+std::vector<std::vector<cv::Point>> process(const RunMask &mask, const ProcessParams &params)
+{
+    int approximation = params.contour_spacing > 0 ? cv::CHAIN_APPROX_SIMPLE : cv::CHAIN_APPROX_NONE;
+    RunComponents components = mask.label_components();
+    std::vector<std::vector<cv::Point>> contours;
+    for (int label = 1; label <= components.count(); label++)
     {
-        auto corners = find_closest_to_corners(card, image.size());
-        ext_points.push_back(corners);
-        reorder_contour_with_bottom_left_first(card, corners[0]);
+        if (may_enclose(components.boxes[label - 1], components.areas[label - 1], params.min_area))
+            contours.push_back(mask.trace(components, label, approximation));
+    }
+    sort_as_find_contours(contours);
+    return find_card_quads(contours, mask.size(), params);
+}
+
+std::vector<std::vector<cv::Point>> upscale_quads(const cv::Mat &image, const std::vector<std::vector<cv::Point>> &quads, int downscale,
+                                                  const ProcessParams &params)
+{
+    // preprocessing_image dilates by 2 pixels and erodes by 7, which moves the corners of a
+    // convex shape inwards by 5 pixels along each axis
+    const int mask_shrink = 5;
+
+    downscale = std::max(1, downscale);
+    int small_tolerance = scale_process_params(params, downscale).pixel_tolerance;
+    // Covers the error of the corner found at low resolution, a few downscaled pixels
+    int radius = 2 * downscale + 4;
+    cv::Rect bounds(0, 0, image.cols, image.rows);
+
+    std::vector<std::vector<cv::Point>> upscaled;
+    for (const auto &quad : quads)
+    {
+        std::vector<cv::Point> corners;
+        for (size_t k = 0; k < quad.size() && k < 4; k++)
+        {
+            // Centre of the downscaled pixel holding the unpadded corner
+            cv::Point small = unpadded_corner(quad, static_cast<int>(k), small_tolerance);
+            cv::Point corner = small * downscale + cv::Point(downscale / 2, downscale / 2);
+
+            // Look for the raw white region, which extends past the mask
+            cv::Point expected = corner + CORNER_OUTWARD[k] * mask_shrink;
+            cv::Rect window = cv::Rect(expected.x - radius, expected.y - radius, 2 * radius + 1, 2 * radius + 1) & bounds;
+            if (!window.empty())
+            {
+                cv::Mat white;
+                white_mask(image(window), white);
+
+                bool found = false;
+                int best_score = 0;
+                cv::Point best;
+                for (int y = 0; y < white.rows; y++)
+                {
+                    const uchar *row = white.ptr<uchar>(y);
+                    for (int x = 0; x < white.cols; x++)
+                    {
+                        int score = CORNER_OUTWARD[k].x * x + CORNER_OUTWARD[k].y * y;
+                        if (row[x] && (!found || score > best_score))
+                        {
+                            found = true;
+                            best_score = score;
+                            best = cv::Point(x, y);
+                        }
+                    }
+                }
+
+                // Cut by the window (but not by the image border): the white region goes on
+                bool cut = (CORNER_OUTWARD[k].x < 0 && best.x == 0 && window.x > 0) ||
+                           (CORNER_OUTWARD[k].x > 0 && best.x == window.width - 1 && window.x + window.width < image.cols) ||
+                           (CORNER_OUTWARD[k].y < 0 && best.y == 0 && window.y > 0) ||
+                           (CORNER_OUTWARD[k].y > 0 && best.y == window.height - 1 && window.y + window.height < image.rows);
+                if (found && !cut)
+                    corner = window.tl() + best - CORNER_OUTWARD[k] * mask_shrink;
+            }
+            corners.push_back(corner + CORNER_OUTWARD[k] * params.pixel_tolerance);
+        }
+        upscaled.push_back(corners);
     }
-    return extract_points_from_pairs(cards, ext_points);
+    return upscaled;
 }
 
 void sharpen_image(cv::Mat &image)
@@ -223,7 +450,7 @@ void sort_corners(std::vector<cv::Point2f> &pts)
     pts = {tl, tr, br, bl};
 }
 
-cv::Mat warp_to_rect(const cv::Mat &src, const std::vector<cv::Point> &quad, const cv::Size &dstSize)
+cv::Mat quad_to_rect_transform(const std::vector<cv::Point> &quad, const cv::Size &dstSize, CardOrientation orientation)
 {
     CV_Assert(quad.size() == 4);
     std::vector<cv::Point2f> srcPts;
@@ -232,29 +459,43 @@ cv::Mat warp_to_rect(const cv::Mat &src, const std::vector<cv::Point> &quad, con
         srcPts.emplace_back(float(p.x), float(p.y));
     sort_corners(srcPts);
 
-    std::vector<cv::Point2f> dstPts = {
+    const cv::Point2f rectPts[4] = {
         cv::Point2f(0.0f, 0.0f),
         cv::Point2f(float(dstSize.width - 1), 0.0f),
         cv::Point2f(float(dstSize.width - 1), float(dstSize.height - 1)),
         cv::Point2f(0.0f, float(dstSize.height - 1))};
 
-    cv::Mat H = cv::getPerspectiveTransform(srcPts, dstPts);
+    // Rotating by k quarter turns clockwise sends each source corner k positions further
+    // along the tl, tr, br, bl cycle of the destination
+    int turns = static_cast<int>(orientation);
+    std::vector<cv::Point2f> dstPts(4);
+    for (int i = 0; i < 4; i++)
+        dstPts[i] = rectPts[(i + turns) % 4];
+
+    return cv::getPerspectiveTransform(srcPts, dstPts);
+}
+
+cv::Mat warp_to_rect(const cv::Mat &src, const std::vector<cv::Point> &quad, const cv::Size &dstSize, CardOrientation orientation)
+{
+    cv::Mat H = quad_to_rect_transform(quad, dstSize, orientation);
     cv::Mat warped;
     cv::warpPerspective(src, warped, H, dstSize, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
 
     return warped;
 }
 
-std::vector<cv::Mat> get_cards(const cv::Mat &src, const std::vector<std::vector<cv::Point>> &rects)
+std::vector<cv::Mat> get_cards(const cv::Mat &src, const std::vector<std::vector<cv::Point>> &rects, WarpCache *cache)
 {
     std::vector<cv::Mat> cards;
 
     cv::Size card_size(400, 600);
     for (auto &rect : rects)
     {
-        cv::Mat card = warp_to_rect(src, rect, card_size);
-        cv::Mat rot_matrix = cv::getRotationMatrix2D(cv::Point2f(card.cols / 2, card.rows / 2), 180, 1);
-        cv::warpAffine(card, card, rot_matrix, cv::Size(card.cols, card.rows));
+        cv::Mat card;
+        if (cache)
+            cache->warp(src, rect, card_size, CardOrientation::Rotate180, card);
+        else
+            card = warp_to_rect(src, rect, card_size, CardOrientation::Rotate180);
 
         // Preprocess (sharpen, binarize, etc.)
         preprocessing_card(card);
@@ -264,3 +505,47 @@ std::vector<cv::Mat> get_cards(const cv::Mat &src, const std::vector<std::vector
     }
     return cards;
 }
+
+std::vector<cv::Mat> get_rank_corners(const cv::Mat &src, const std::vector<std::vector<cv::Point>> &rects, const cv::Size &corner_size)
+{
+    std::vector<cv::Mat> corners;
+
+    const cv::Size card_size(400, 600);
+    const cv::Size grid(8, 8);
+    const cv::Size tile(card_size.width / grid.width, card_size.height / grid.height);
+    // Pixels read past the window by the 3x3 sharpening and the 9x9 blur
+    const int reach = 5;
+
+    // CLAHE interpolates a pixel between the tiles whose centres surround it, so tiles up to the
+    // one after the last pixel read give it the same value as on the whole card
+    auto tiles_up_to = [](int last, int size, int count)
+    {
+        return std::min(count, std::max(0, last - size / 2) / size + 2);
+    };
+    cv::Size region_tiles(tiles_up_to(corner_size.width - 1 + reach, tile.width, grid.width),
+                          tiles_up_to(corner_size.height - 1 + reach, tile.height, grid.height));
+    cv::Size region_size(region_tiles.width * tile.width, region_tiles.height * tile.height);
+    cv::Size small_size(card_size.width / 2, card_size.height / 2);
+
+    for (auto &rect : rects)
+    {
+        // Same homography as get_cards; the smaller output keeps the top-left part of the card
+        cv::Mat corner;
+        cv::warpPerspective(src, corner, quad_to_rect_transform(rect, card_size, CardOrientation::Rotate180), region_size,
+                            cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        enhance_card(corner, region_tiles);
+
+        // Otsu threshold of the whole card, from a half resolution copy
+        cv::Mat small;
+        cv::warpPerspective(src, small, quad_to_rect_transform(rect, small_size, CardOrientation::Rotate180), small_size,
+                            cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        enhance_card(small, grid, cv::Size(5, 5));
+        double threshold = cv::threshold(small, small, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+
+        cv::Mat window = corner(cv::Rect(0, 0, corner_size.width, corner_size.height));
+        cv::Mat binary;
+        cv::threshold(window, binary, threshold, 255, cv::THRESH_BINARY);
+        corners.push_back(binary);
+    }
+    return corners;
+}
@@ -0,0 +1,41 @@
+#include "render.hpp"
+#include "evaluation.hpp"
+
+// Blends `color` into the pixels of `frame` covered by `quad`, touching only its bounding box.
+static void tint_quad(cv::Mat &frame, const std::vector<cv::Point> &quad, const cv::Scalar &color, double alpha)
+{
+    cv::Rect bbox = cv::boundingRect(quad) & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (bbox.area() == 0)
+        return;
+
+    cv::Mat mask = cv::Mat::zeros(bbox.size(), CV_8U);
+    std::vector<std::vector<cv::Point>> poly{quad};
+    cv::fillPoly(mask, poly, cv::Scalar(255), cv::LINE_8, 0, -bbox.tl());
+
+    cv::Mat region = frame(bbox);
+    cv::Mat tint(bbox.size(), frame.type(), color);
+    cv::Mat blended;
+    cv::addWeighted(tint, alpha, region, 1 - alpha, 0, blended);
+    blended.copyTo(region, mask);
+}
+
+void draw_card_overlays(cv::Mat &frame, const std::vector<std::vector<cv::Point>> &rects, const std::vector<std::string> &texts, double alpha)
+{
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        int hilo_value = get_hi_lo_value(texts[i]);
+        cv::Scalar color = get_color_for_value(hilo_value);
+
+        tint_quad(frame, rects[i], color, alpha);
+        std::vector<std::vector<cv::Point>> poly{rects[i]};
+        cv::drawContours(frame, poly, -1, color, 1);
+
+        cv::Rect bbox = cv::boundingRect(rects[i]);
+        cv::Point top_left = bbox.tl() + cv::Point(0, 0);
+        putText(frame, texts[i], top_left, cv::FONT_HERSHEY_SIMPLEX, 0.7, color, 2);
+
+        cv::Point bottom_right = bbox.br() - cv::Point(-5, 10);
+        std::string hilo_str = (hilo_value > 0 ? "+" : "") + std::to_string(hilo_value);
+        putText(frame, hilo_str, bottom_right, cv::FONT_HERSHEY_SIMPLEX, 0.6, color, 2);
+    }
+}
@@ -0,0 +1,461 @@
+#include "rle_mask.hpp"
+
+#include <numeric>
+
+using Run = RunMask::Run;
+
+// Union-find over indices, with path halving
+static int find_root(std::vector<int> &parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void join(std::vector<int> &parent, int a, int b)
+{
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a != b)
+        parent[std::max(a, b)] = std::min(a, b);
+}
+
+// Union of two sorted lists of disjoint runs; runs that touch are merged
+static void unite_runs(const Run *a, const Run *a_end, const Run *b, const Run *b_end, std::vector<Run> &out)
+{
+    out.clear();
+    while (a != a_end || b != b_end)
+    {
+        const Run &next = (b == b_end || (a != a_end && a->start <= b->start)) ? *a++ : *b++;
+        if (!out.empty() && next.start <= out.back().end)
+            out.back().end = std::max(out.back().end, next.end);
+        else
+            out.push_back(next);
+    }
+}
+
+// Intersection of two sorted lists of disjoint runs
+static void intersect_runs(const Run *a, const Run *a_end, const Run *b, const Run *b_end, std::vector<Run> &out)
+{
+    out.clear();
+    while (a != a_end && b != b_end)
+    {
+        int start = std::max(a->start, b->start), end = std::min(a->end, b->end);
+        if (start < end)
+            out.push_back({start, end});
+        if (a->end < b->end)
+            a++;
+        else
+            b++;
+    }
+}
+
+// Complement of a sorted list of disjoint runs within [0, cols)
+static void complement_runs(const Run *a, const Run *a_end, int cols, std::vector<Run> &out)
+{
+    out.clear();
+    int x = 0;
+    for (; a != a_end; a++)
+    {
+        if (a->start > x)
+            out.push_back({x, a->start});
+        x = a->end;
+    }
+    if (x < cols)
+        out.push_back({x, cols});
+}
+
+RunMask::RunMask(const cv::Size &size)
+    : rows_(size.height), cols_(size.width)
+{
+    row_start_.assign(rows_ + 1, 0);
+}
+
+RunMask RunMask::from_mat(const cv::Mat &mask)
+{
+    CV_Assert(mask.type() == CV_8U);
+    RunMask encoded(cv::Size(mask.cols, 0));
+    for (int y = 0; y < mask.rows; y++)
+        encoded.push_row(mask.ptr<uchar>(y));
+    return encoded;
+}
+
+void RunMask::to_mat(cv::Mat &mask) const
+{
+    mask.create(size(), CV_8U);
+    for (int y = 0; y < rows_; y++)
+    {
+        uchar *dst = mask.ptr<uchar>(y);
+        std::fill(dst, dst + cols_, 0);
+        for (const Run *r = row_begin(y); r != row_end(y); r++)
+            std::fill(dst + r->start, dst + r->end, 255);
+    }
+}
+
+cv::Size RunMask::size() const
+{
+    return cv::Size(cols_, rows_);
+}
+
+size_t RunMask::count() const
+{
+    size_t total = 0;
+    for (const Run &r : runs_)
+        total += r.end - r.start;
+    return total;
+}
+
+size_t RunMask::count(const cv::Rect &area) const
+{
+    cv::Rect r = area & cv::Rect(0, 0, cols_, rows_);
+    size_t total = 0;
+    for (int y = r.y; y < r.y + r.height; y++)
+    {
+        for (const Run *run = row_begin(y); run != row_end(y); run++)
+        {
+            int start = std::max(run->start, r.x), end = std::min(run->end, r.x + r.width);
+            if (start < end)
+                total += end - start;
+        }
+    }
+    return total;
+}
+
+size_t RunMask::run_count() const
+{
+    return runs_.size();
+}
+
+void RunMask::push_row(const uchar *pixels)
+{
+    int x = 0;
+    while (x < cols_)
+    {
+        while (x < cols_ && !pixels[x])
+            x++;
+        int start = x;
+        while (x < cols_ && pixels[x])
+            x++;
+        if (x > start)
+            runs_.push_back({start, x});
+    }
+    row_start_.push_back(static_cast<int>(runs_.size()));
+    rows_++;
+}
+
+RunMask RunMask::dilate(const cv::Size &kernel_size) const
+{
+    // A rectangle is separable: rows first, then columns. The anchor is the kernel centre, and
+    // pixel x receives the pixels x - ax to x + kernel_size.width - 1 - ax.
+    int ax = kernel_size.width / 2, ay = kernel_size.height / 2;
+    int left = kernel_size.width - 1 - ax, right = ax;
+
+    RunMask horizontal(cv::Size(cols_, 0));
+    std::vector<Run> row;
+    for (int y = 0; y < rows_; y++)
+    {
+        row.clear();
+        for (const Run *r = row_begin(y); r != row_end(y); r++)
+            row.push_back({std::max(0, r->start - left), std::min(cols_, r->end + right)});
+        horizontal.append_row(row);
+    }
+
+    RunMask result(cv::Size(cols_, 0));
+    std::vector<Run> merged;
+    for (int y = 0; y < rows_; y++)
+    {
+        int y0 = std::max(0, y - ay), y1 = std::min(rows_ - 1, y + kernel_size.height - 1 - ay);
+        row.assign(horizontal.row_begin(y0), horizontal.row_end(y0));
+        for (int sy = y0 + 1; sy <= y1; sy++)
+        {
+            unite_runs(row.data(), row.data() + row.size(), horizontal.row_begin(sy), horizontal.row_end(sy), merged);
+            row.swap(merged);
+        }
+        result.append_row(row);
+    }
+    return result;
+}
+
+RunMask RunMask::erode(const cv::Size &kernel_size) const
+{
+    // Pixels outside the mask count as set: a run touching the border keeps its end there
+    int ax = kernel_size.width / 2, ay = kernel_size.height / 2;
+    int left = ax, right = kernel_size.width - 1 - ax;
+
+    RunMask horizontal(cv::Size(cols_, 0));
+    std::vector<Run> row;
+    for (int y = 0; y < rows_; y++)
+    {
+        row.clear();
+        for (const Run *r = row_begin(y); r != row_end(y); r++)
+        {
+            int start = r->start == 0 ? 0 : r->start + left;
+            int end = r->end == cols_ ? cols_ : r->end - right;
+            if (start < end)
+                row.push_back({start, end});
+        }
+        horizontal.append_row(row);
+    }
+
+    RunMask result(cv::Size(cols_, 0));
+    std::vector<Run> common;
+    for (int y = 0; y < rows_; y++)
+    {
+        int y0 = std::max(0, y - ay), y1 = std::min(rows_ - 1, y + kernel_size.height - 1 - ay);
+        row.assign(horizontal.row_begin(y0), horizontal.row_end(y0));
+        for (int sy = y0 + 1; sy <= y1 && !row.empty(); sy++)
+        {
+            intersect_runs(row.data(), row.data() + row.size(), horizontal.row_begin(sy), horizontal.row_end(sy), common);
+            row.swap(common);
+        }
+        result.append_row(row);
+    }
+    return result;
+}
+
+void RunMask::fill_holes()
+{
+    if (rows_ == 0 || cols_ == 0)
+        return;
+
+    // Gaps between the runs, i.e. the runs of cleared pixels
+    std::vector<Run> gaps, row;
+    std::vector<int> gap_start = {0};
+    for (int y = 0; y < rows_; y++)
+    {
+        complement_runs(row_begin(y), row_end(y), cols_, row);
+        gaps.insert(gaps.end(), row.begin(), row.end());
+        gap_start.push_back(static_cast<int>(gaps.size()));
+    }
+
+    // Node 0 stands for the outside of the mask; gap i is node i + 1
+    std::vector<int> parent(gaps.size() + 1);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (int y = 0; y < rows_; y++)
+    {
+        for (int i = gap_start[y]; i < gap_start[y + 1]; i++)
+        {
+            if (y == 0 || y == rows_ - 1 || gaps[i].start == 0 || gaps[i].end == cols_)
+                join(parent, 0, i + 1);
+        }
+        if (y == 0)
+            continue;
+
+        // Background is 4-connected: gaps of adjacent rows join when they share a column
+        int i = gap_start[y - 1], j = gap_start[y];
+        while (i < gap_start[y] && j < gap_start[y + 1])
+        {
+            if (std::max(gaps[i].start, gaps[j].start) < std::min(gaps[i].end, gaps[j].end))
+                join(parent, i + 1, j + 1);
+            if (gaps[i].end < gaps[j].end)
+                i++;
+            else
+                j++;
+        }
+    }
+
+    // The gaps the border cannot reach become part of the shapes
+    RunMask filled(cv::Size(cols_, 0));
+    std::vector<Run> background;
+    for (int y = 0; y < rows_; y++)
+    {
+        background.clear();
+        for (int i = gap_start[y]; i < gap_start[y + 1]; i++)
+        {
+            if (find_root(parent, i + 1) == 0)
+                background.push_back(gaps[i]);
+        }
+        complement_runs(background.data(), background.data() + background.size(), cols_, row);
+        filled.append_row(row);
+    }
+    *this = std::move(filled);
+}
+
+void RunMask::paste(const cv::Rect &area, const RunMask &patch, const cv::Point &patch_origin)
+{
+    cv::Rect target = area & cv::Rect(0, 0, cols_, rows_);
+    RunMask pasted(cv::Size(cols_, 0));
+    std::vector<Run> row, kept, inserted;
+    for (int y = 0; y < rows_; y++)
+    {
+        if (y < target.y || y >= target.y + target.height)
+        {
+            row.assign(row_begin(y), row_end(y));
+            pasted.append_row(row);
+            continue;
+        }
+
+        // Pixels of this row outside the area, then the patch pixels moved into it
+        kept.clear();
+        for (const Run *r = row_begin(y); r != row_end(y); r++)
+        {
+            if (r->start < target.x)
+                kept.push_back({r->start, std::min(r->end, target.x)});
+            if (r->end > target.x + target.width)
+                kept.push_back({std::max(r->start, target.x + target.width), r->end});
+        }
+        inserted.clear();
+        int py = patch_origin.y + y - area.y, dx = area.x - patch_origin.x;
+        if (py >= 0 && py < patch.rows_)
+        {
+            for (const Run *r = patch.row_begin(py); r != patch.row_end(py); r++)
+            {
+                int start = std::max(r->start + dx, target.x), end = std::min(r->end + dx, target.x + target.width);
+                if (start < end)
+                    inserted.push_back({start, end});
+            }
+        }
+        unite_runs(kept.data(), kept.data() + kept.size(), inserted.data(), inserted.data() + inserted.size(), row);
+        pasted.append_row(row);
+    }
+    *this = std::move(pasted);
+}
+
+RunComponents RunMask::label_components() const
+{
+    int n = static_cast<int>(runs_.size());
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    // Shapes are 8-connected: runs of adjacent rows join when they touch, diagonally included
+    for (int y = 1; y < rows_; y++)
+    {
+        int i = row_start_[y - 1], j = row_start_[y];
+        while (i < row_start_[y] && j < row_start_[y + 1])
+        {
+            if (runs_[i].start <= runs_[j].end && runs_[j].start <= runs_[i].end)
+                join(parent, i, j);
+            if (runs_[i].end < runs_[j].end)
+                i++;
+            else
+                j++;
+        }
+    }
+
+    // Roots are the first run of their component, so labels follow the raster order
+    RunComponents components;
+    components.run_labels.resize(n);
+    for (int y = 0; y < rows_; y++)
+    {
+        for (int i = row_start_[y]; i < row_start_[y + 1]; i++)
+        {
+            int root = find_root(parent, i);
+            int label;
+            if (root == i)
+            {
+                components.boxes.emplace_back(runs_[i].start, y, runs_[i].end - runs_[i].start, 1);
+                components.areas.push_back(0);
+                label = components.count();
+            }
+            else
+            {
+                label = components.run_labels[root];
+            }
+            components.run_labels[i] = label;
+
+            cv::Rect &box = components.boxes[label - 1];
+            int x0 = std::min(box.x, runs_[i].start), x1 = std::max(box.x + box.width, runs_[i].end);
+            box = cv::Rect(x0, box.y, x1 - x0, y + 1 - box.y);
+            components.areas[label - 1] += runs_[i].end - runs_[i].start;
+        }
+    }
+    return components;
+}
+
+std::vector<cv::Point> RunMask::trace(const RunComponents &components, int label, int approximation) const
+{
+    // Chain code directions of OpenCV: 0 is +x, then counterclockwise on screen
+    static const cv::Point step[8] = {cv::Point(1, 0), cv::Point(1, -1), cv::Point(0, -1), cv::Point(-1, -1),
+                                      cv::Point(-1, 0), cv::Point(-1, 1), cv::Point(0, 1), cv::Point(1, 1)};
+    auto inside = [&](const cv::Point &p)
+    {
+        int i = find_run(p.x, p.y);
+        return i >= 0 && components.run_labels[i] == label;
+    };
+
+    // First pixel in raster order: the first run of the component in its top row
+    const cv::Rect &box = components.boxes[label - 1];
+    cv::Point start(-1, box.y);
+    for (int i = row_start_[box.y]; i < row_start_[box.y + 1] && start.x < 0; i++)
+    {
+        if (components.run_labels[i] == label)
+            start.x = runs_[i].start;
+    }
+
+    std::vector<cv::Point> contour;
+    // Clockwise from the left neighbour, which is background, for the first border pixel
+    int s = 4;
+    do
+        s = (s - 1) & 7;
+    while (s != 4 && !inside(start + step[s]));
+    if (s == 4)
+    {
+        contour.push_back(start);
+        return contour;
+    }
+
+    cv::Point first = start + step[s];
+    cv::Point current = start;
+    int prev_s = s ^ 4;
+    while (true)
+    {
+        // Counterclockwise from the pixel we came from for the next border pixel
+        int k = s;
+        cv::Point next;
+        do
+            next = current + step[++k & 7];
+        while (!inside(next));
+        s = k & 7;
+
+        if (s != prev_s || approximation == cv::CHAIN_APPROX_NONE)
+        {
+            contour.push_back(current);
+            prev_s = s;
+        }
+        if (next == start && current == first)
+            break;
+        current = next;
+        s = (s + 4) & 7;
+    }
+    return contour;
+}
+
+const Run *RunMask::row_begin(int y) const
+{
+    return runs_.data() + row_start_[y];
+}
+
+const Run *RunMask::row_end(int y) const
+{
+    return runs_.data() + row_start_[y + 1];
+}
+
+void RunMask::append_row(const std::vector<Run> &runs)
+{
+    int first = static_cast<int>(runs_.size());
+    for (const Run &r : runs)
+    {
+        if (static_cast<int>(runs_.size()) > first && r.start <= runs_.back().end)
+            runs_.back().end = std::max(runs_.back().end, r.end);
+        else
+            runs_.push_back(r);
+    }
+    row_start_.push_back(static_cast<int>(runs_.size()));
+    rows_++;
+}
+
+int RunMask::find_run(int x, int y) const
+{
+    if (y < 0 || y >= rows_ || x < 0 || x >= cols_)
+        return -1;
+
+    // Last run of the row starting at or before x
+    const Run *r = std::upper_bound(row_begin(y), row_end(y), x, [](int value, const Run &run)
+                                    { return value < run.start; });
+    if (r == row_begin(y) || (r - 1)->end <= x)
+        return -1;
+    return static_cast<int>(r - 1 - runs_.data());
+}
@@ -0,0 +1,89 @@
+#include "stride_controller.hpp"
+
+#include <algorithm>
+
+StrideController::StrideController(double target_latency_ms, int max_stride, int initial_stride, bool adaptive, double smoothing)
+    : target_latency_ms_(target_latency_ms), max_stride_(std::max(1, max_stride)), adaptive_(adaptive), smoothing_(smoothing)
+{
+    // A fixed stride, such as the one of an offline run, is used as given
+    stride_ = std::max(1, initial_stride);
+    if (adaptive_)
+        stride_ = std::min(stride_, max_stride_);
+    since_keyframe_ = stride_; // The first frame is always a keyframe
+}
+
+bool StrideController::next_frame()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (++since_keyframe_ >= stride_)
+    {
+        since_keyframe_ = 0;
+        return true;
+    }
+    return false;
+}
+
+void StrideController::record(double keyframe_ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    keyframe_ms_ = has_sample_ ? keyframe_ms_ + smoothing_ * (keyframe_ms - keyframe_ms_) : keyframe_ms;
+    has_sample_ = true;
+    update_stride();
+}
+
+void StrideController::record_intermediate(double frame_ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    intermediate_ms_ = has_intermediate_sample_ ? intermediate_ms_ + smoothing_ * (frame_ms - intermediate_ms_) : frame_ms;
+    has_intermediate_sample_ = true;
+    update_stride();
+}
+
+int StrideController::stride() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stride_;
+}
+
+double StrideController::keyframe_latency_ms() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keyframe_ms_;
+}
+
+double StrideController::intermediate_latency_ms() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return intermediate_ms_;
+}
+
+double StrideController::frame_latency_ms() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return amortized_ms(stride_);
+}
+
+double StrideController::amortized_ms(int stride) const
+{
+    return (keyframe_ms_ + (stride - 1) * intermediate_ms_) / stride;
+}
+
+void StrideController::update_stride()
+{
+    if (!adaptive_ || !has_sample_ || target_latency_ms_ <= 0.0)
+        return;
+
+    // When frames in between cost more than keyframes, a longer stride only makes things worse
+    int best = 1;
+    for (int stride = 1; stride <= max_stride_; stride++)
+    {
+        if (amortized_ms(stride) <= target_latency_ms_)
+        {
+            best = stride;
+            break;
+        }
+        if (amortized_ms(stride) < amortized_ms(best))
+            best = stride;
+    }
+    stride_ = best;
+}
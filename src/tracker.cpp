@@ -0,0 +1,116 @@
+#include "tracker.hpp"
+#include "evaluation.hpp"
+
+static cv::Point2f quad_centroid(const std::vector<cv::Point> &quad)
+{
+    cv::Point2f centroid(0.0f, 0.0f);
+    for (const auto &pt : quad)
+        centroid += cv::Point2f(float(pt.x), float(pt.y));
+    return quad.empty() ? centroid : centroid * (1.0 / quad.size());
+}
+
+static double max_corner_displacement(const std::vector<cv::Point> &a, const std::vector<cv::Point> &b)
+{
+    if (a.size() != b.size())
+        return std::numeric_limits<double>::max();
+
+    double displacement = 0.0;
+    for (size_t i = 0; i < a.size(); ++i)
+        displacement = std::max(displacement, cv::norm(a[i] - b[i]));
+    return displacement;
+}
+
+CardTracker::CardTracker(double min_iou, double max_centroid_distance, double move_threshold, int max_missed)
+    : min_iou_(min_iou), max_centroid_distance_(max_centroid_distance), move_threshold_(move_threshold), max_missed_(max_missed)
+{
+}
+
+std::vector<CardTrack *> CardTracker::update(const std::vector<std::vector<cv::Point>> &quads)
+{
+    struct Candidate
+    {
+        double iou;
+        double distance;
+        size_t track;
+        size_t quad;
+    };
+
+    std::vector<Candidate> candidates;
+    for (size_t t = 0; t < tracks_.size(); ++t)
+    {
+        cv::Point2f track_centroid = quad_centroid(tracks_[t].quad);
+        for (size_t q = 0; q < quads.size(); ++q)
+        {
+            double iou = compute_iou(tracks_[t].quad, quads[q]);
+            double distance = cv::norm(track_centroid - quad_centroid(quads[q]));
+            if (iou >= min_iou_ || distance <= max_centroid_distance_)
+                candidates.push_back({iou, distance, t, q});
+        }
+    }
+
+    // Greedy assignment: best overlaps first, closest centroids breaking ties
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+              {
+                  if (a.iou != b.iou)
+                      return a.iou > b.iou;
+                  return a.distance < b.distance; });
+
+    std::vector<int> track_to_quad(tracks_.size(), -1);
+    std::vector<bool> quad_matched(quads.size(), false);
+    for (const auto &c : candidates)
+    {
+        if (track_to_quad[c.track] >= 0 || quad_matched[c.quad])
+            continue;
+        track_to_quad[c.track] = static_cast<int>(c.quad);
+        quad_matched[c.quad] = true;
+    }
+
+    std::vector<CardTrack> next_tracks;
+    std::vector<size_t> quad_to_slot(quads.size(), 0);
+    for (size_t t = 0; t < tracks_.size(); ++t)
+    {
+        CardTrack &track = tracks_[t];
+        if (track_to_quad[t] >= 0)
+        {
+            track.quad = quads[track_to_quad[t]];
+            track.missed = 0;
+            quad_to_slot[track_to_quad[t]] = next_tracks.size();
+        }
+        else if (++track.missed > max_missed_)
+        {
+            continue;
+        }
+        next_tracks.push_back(std::move(track));
+    }
+
+    for (size_t q = 0; q < quads.size(); ++q)
+    {
+        if (quad_matched[q])
+            continue;
+
+        CardTrack track;
+        track.id = next_id_++;
+        track.quad = quads[q];
+        quad_to_slot[q] = next_tracks.size();
+        next_tracks.push_back(std::move(track));
+    }
+    tracks_ = std::move(next_tracks);
+
+    std::vector<CardTrack *> matched;
+    matched.reserve(quads.size());
+    for (size_t q = 0; q < quads.size(); ++q)
+        matched.push_back(&tracks_[quad_to_slot[q]]);
+    return matched;
+}
+
+bool CardTracker::needs_classification(const CardTrack &track) const
+{
+    if (track.classified_quad.empty())
+        return true;
+    return max_corner_displacement(track.quad, track.classified_quad) > move_threshold_;
+}
+
+void CardTracker::clear()
+{
+    tracks_.clear();
+}
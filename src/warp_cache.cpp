@@ -0,0 +1,83 @@
+#include "warp_cache.hpp"
+
+WarpCache::WarpCache(double tolerance, int max_age)
+    : tolerance_(tolerance), max_age_(std::max(0, max_age))
+{
+}
+
+void WarpCache::warp(const cv::Mat &src, const std::vector<cv::Point> &quad, const cv::Size &card_size, CardOrientation orientation,
+                     cv::Mat &dst)
+{
+    CV_Assert(quad.size() == 4);
+    std::vector<cv::Point2f> corners;
+    corners.reserve(4);
+    for (const auto &p : quad)
+        corners.emplace_back(float(p.x), float(p.y));
+    sort_corners(corners);
+
+    Entry *entry = nullptr;
+    for (auto &e : entries_)
+    {
+        if (e.card_size != card_size || e.orientation != orientation)
+            continue;
+
+        bool stable = true;
+        for (size_t i = 0; i < 4 && stable; i++)
+            stable = cv::norm(e.corners[i] - corners[i]) <= tolerance_;
+        if (stable)
+        {
+            entry = &e;
+            break;
+        }
+    }
+
+    if (entry)
+    {
+        hits_++;
+    }
+    else
+    {
+        misses_++;
+
+        // Source coordinates of every destination pixel, as warpPerspective computes them
+        cv::Mat H = quad_to_rect_transform(quad, card_size, orientation);
+        cv::Mat grid(card_size, CV_32FC2);
+        for (int y = 0; y < card_size.height; y++)
+        {
+            cv::Point2f *row = grid.ptr<cv::Point2f>(y);
+            for (int x = 0; x < card_size.width; x++)
+                row[x] = cv::Point2f(float(x), float(y));
+        }
+        cv::Mat map;
+        cv::perspectiveTransform(grid, map, H.inv());
+
+        Entry e;
+        e.corners = corners;
+        e.card_size = card_size;
+        e.orientation = orientation;
+        cv::convertMaps(map, cv::noArray(), e.map_xy, e.map_idx, CV_16SC2);
+        entries_.push_back(std::move(e));
+        entry = &entries_.back();
+    }
+
+    entry->last_used = frame_;
+    cv::remap(src, dst, entry->map_xy, entry->map_idx, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+}
+
+void WarpCache::next_frame()
+{
+    frame_++;
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [this](const Entry &e)
+                                  { return frame_ - e.last_used > max_age_; }),
+                   entries_.end());
+}
+
+size_t WarpCache::hits() const
+{
+    return hits_;
+}
+
+size_t WarpCache::misses() const
+{
+    return misses_;
+}
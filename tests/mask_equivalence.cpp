@@ -0,0 +1,170 @@
+#include "bit_mask.hpp"
+#include "preprocess.hpp"
+#include "rle_mask.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// Randomized check that BitMask and RunMask give the same results as their OpenCV
+// counterparts: cv::dilate and cv::erode with the default borders, fill_holes (a flood fill of
+// the background), cv::connectedComponentsWithStats and cv::findContours with RETR_EXTERNAL.
+// Usage: mask_equivalence [masks] [seed]
+
+static int failures = 0;
+
+static void check(bool ok, const std::string &what, int index)
+{
+    if (ok)
+        return;
+    failures++;
+    std::cerr << what << " differs from OpenCV on mask " << index << "\n";
+}
+
+static bool same(const cv::Mat &a, const cv::Mat &b)
+{
+    return a.size() == b.size() && cv::countNonZero(a != b) == 0;
+}
+
+// Random 0/255 mask made of filled shapes, rings that leave holes, and salt and pepper noise;
+// the first two masks are empty and full, and the sizes cross the 64-pixel words of BitMask
+static cv::Mat random_mask(cv::RNG &rng, int index)
+{
+    cv::Size size(rng.uniform(1, 200), rng.uniform(1, 150));
+    cv::Mat mask = cv::Mat::zeros(size, CV_8U);
+    if (index == 0)
+        return mask;
+    if (index == 1)
+        return cv::Mat(size, CV_8U, cv::Scalar(255));
+
+    int shapes = rng.uniform(0, 8);
+    for (int i = 0; i < shapes; i++)
+    {
+        cv::Point centre(rng.uniform(-10, size.width + 10), rng.uniform(-10, size.height + 10));
+        cv::Size axes(rng.uniform(1, size.width / 2 + 2), rng.uniform(1, size.height / 2 + 2));
+        double angle = rng.uniform(0.0, 180.0);
+        switch (rng.uniform(0, 4))
+        {
+        case 0:
+            cv::rectangle(mask, cv::Rect(centre - cv::Point(axes), axes * 2), cv::Scalar(255), cv::FILLED);
+            break;
+        case 1:
+            cv::ellipse(mask, centre, axes, angle, 0, 360, cv::Scalar(255), cv::FILLED);
+            break;
+        case 2:
+            cv::ellipse(mask, centre, axes, angle, 0, 360, cv::Scalar(255), rng.uniform(1, 4));
+            break;
+        default:
+        {
+            cv::Point2f corners[4];
+            cv::RotatedRect(centre, cv::Size2f(axes * 2), static_cast<float>(angle)).points(corners);
+            std::vector<cv::Point> polygon(corners, corners + 4);
+            cv::fillConvexPoly(mask, polygon, cv::Scalar(255));
+        }
+        }
+    }
+
+    if (rng.uniform(0, 2))
+    {
+        cv::Mat noise(size, CV_8U);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 100);
+        mask.setTo(255, noise < 3);
+        mask.setTo(0, noise > 96);
+    }
+    return mask;
+}
+
+static void check_morphology(const cv::Mat &mask, cv::RNG &rng, int index)
+{
+    cv::Size kernel_size(rng.uniform(1, 18), rng.uniform(1, 18));
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, kernel_size);
+    std::string kernel_name = std::to_string(kernel_size.width) + "x" + std::to_string(kernel_size.height);
+    BitMask bits = BitMask::from_mat(mask);
+    RunMask runs = RunMask::from_mat(mask);
+    cv::Mat expected, result;
+
+    bits.to_mat(result);
+    check(same(result, mask), "BitMask round trip", index);
+    runs.to_mat(result);
+    check(same(result, mask), "RunMask round trip", index);
+
+    cv::dilate(mask, expected, kernel);
+    bits.dilate(kernel_size).to_mat(result);
+    check(same(result, expected), "BitMask::dilate " + kernel_name, index);
+    runs.dilate(kernel_size).to_mat(result);
+    check(same(result, expected), "RunMask::dilate " + kernel_name, index);
+
+    cv::erode(mask, expected, kernel);
+    bits.erode(kernel_size).to_mat(result);
+    check(same(result, expected), "BitMask::erode " + kernel_name, index);
+    runs.erode(kernel_size).to_mat(result);
+    check(same(result, expected), "RunMask::erode " + kernel_name, index);
+
+    expected = mask.clone();
+    fill_holes(expected);
+    bits.fill_holes();
+    bits.to_mat(result);
+    check(same(result, expected), "BitMask::fill_holes", index);
+    runs.fill_holes();
+    runs.to_mat(result);
+    check(same(result, expected), "RunMask::fill_holes", index);
+}
+
+static void check_contours(const cv::Mat &mask, int index)
+{
+    cv::Mat labels, stats, centroids;
+    int count = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S) - 1;
+    RunMask runs = RunMask::from_mat(mask);
+    RunComponents components = runs.label_components();
+    check(components.count() == count, "RunMask::label_components count", index);
+
+    for (int label = 1; label <= components.count(); label++)
+    {
+        // OpenCV label of the component with the same box and area that starts on the first row of the box
+        const cv::Rect &box = components.boxes[label - 1];
+        int area = components.areas[label - 1];
+        int match = 0;
+        for (int x = box.x; x < box.x + box.width && match == 0; x++)
+        {
+            int other = labels.at<int>(box.y, x);
+            const int *row = stats.ptr<int>(other);
+            if (other > 0 && cv::Rect(row[cv::CC_STAT_LEFT], row[cv::CC_STAT_TOP], row[cv::CC_STAT_WIDTH], row[cv::CC_STAT_HEIGHT]) == box &&
+                row[cv::CC_STAT_AREA] == area)
+                match = other;
+        }
+        check(match > 0, "RunMask::label_components box and area", index);
+        if (match == 0)
+            continue;
+
+        cv::Mat component = labels == match;
+        for (int approximation : {cv::CHAIN_APPROX_NONE, cv::CHAIN_APPROX_SIMPLE})
+        {
+            std::vector<std::vector<cv::Point>> expected;
+            cv::findContours(component, expected, cv::RETR_EXTERNAL, approximation);
+            bool ok = expected.size() == 1 && runs.trace(components, label, approximation) == expected.front();
+            check(ok, approximation == cv::CHAIN_APPROX_NONE ? "RunMask::trace" : "RunMask::trace (simple)", index);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int masks = argc > 1 ? std::atoi(argv[1]) : 500;
+    uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+    cv::RNG rng(seed);
+    for (int i = 0; i < masks; i++)
+    {
+        cv::Mat mask = random_mask(rng, i);
+        check_morphology(mask, rng, i);
+        check_contours(mask, i);
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " mismatches over " << masks << " masks (seed " << seed << ")\n";
+        return 1;
+    }
+    std::cout << "BitMask and RunMask match OpenCV on " << masks << " masks (seed " << seed << ")\n";
+    return 0;
+}